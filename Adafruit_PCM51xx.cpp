@@ -25,27 +25,99 @@
 
 #include "Adafruit_PCM51xx.h"
 
+// Placement new for the in-place bus device
+#ifdef __AVR__
+#include <new.h>
+#else
+#include <new>
+#endif
+
+#ifdef PCM51XX_INSTRUMENT
+/*! @brief Time the rest of the enclosing call into its latency histogram */
+#define PCM51XX_TIME_API(api) ApiTimer api_timer(this, api)
+#else
+#define PCM51XX_TIME_API(api) ///< Instrumentation disabled
+#endif
+
 /*!
  * @brief Constructor for PCM51xx
  */
 Adafruit_PCM51xx::Adafruit_PCM51xx(void) {
   _page = 0xFF; // Initialize to invalid page to force first page select
+#ifndef PCM51XX_SPI_ONLY
   i2c_dev = nullptr;
+#endif
+#ifndef PCM51XX_I2C_ONLY
   spi_dev = nullptr;
+#endif
+  _txn = nullptr;
+  _lock = nullptr;
+  _unlock = nullptr;
+  _lock_arg = nullptr;
+  resetBusStats();
+  _retries = 0;
+  _retry_backoff = 100;
+  _auto_recover = false;
+  _reset_check = false;
+  _recovering = false;
+  _error_detect = 0;
+  _last_error = PCM51XX_ERROR_NONE;
+  resetErrorStats();
+#ifdef PCM51XX_INSTRUMENT
+  resetInstrumentation();
+#endif
+#ifdef PCM51XX_TRACE
+  _trace_enabled = true;
+  clearTrace();
+#endif
+  _boot_time = 0;
+  _boot_transactions = 0;
+  _op.op = PCM51XX_OP_NONE;
+  _op.status = PCM51XX_OP_IDLE;
+  _op.polls = 0;
+  _op.elapsed = 0;
+  _fading = false;
+  _fade_min_interval = 2000;
+  memset(&_dsp_load, 0, sizeof(_dsp_load));
+  _clock_plan_valid = false;
+  _switch_time = 0;
+  memset(_event_gpio, 0, sizeof(_event_gpio));
+  memset(_event_callbacks, 0, sizeof(_event_callbacks));
+  _event_active = 0;
+  _event_pending = false;
+#ifndef PCM51XX_NO_CACHE
+  _cache_enabled = false;
+#endif
+  invalidateCache();
 }
 
 /*!
  * @brief Destructor for PCM51xx
  */
 Adafruit_PCM51xx::~Adafruit_PCM51xx(void) {
+  detachEventPins();
+  releaseBus();
+}
+
+/*!
+ * @brief Destroy the bus device held in _bus, if any
+ */
+void Adafruit_PCM51xx::releaseBus(void) {
+#ifndef PCM51XX_SPI_ONLY
   if (i2c_dev) {
-    delete i2c_dev;
+    i2c_dev->~Adafruit_I2CDevice();
+    i2c_dev = nullptr;
   }
+#endif
+#ifndef PCM51XX_I2C_ONLY
   if (spi_dev) {
-    delete spi_dev;
+    spi_dev->~Adafruit_SPIDevice();
+    spi_dev = nullptr;
   }
+#endif
 }
 
+#ifndef PCM51XX_SPI_ONLY
 /*!
  * @brief Initialize the PCM512x
  * @param i2c_addr I2C address (default is PCM51XX_DEFAULT_ADDR)
@@ -53,15 +125,8 @@ Adafruit_PCM51xx::~Adafruit_PCM51xx(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::begin(uint8_t i2c_addr, TwoWire* wire) {
-  if (i2c_dev) {
-    delete i2c_dev;
-  }
-  if (spi_dev) {
-    delete spi_dev;
-    spi_dev = nullptr;
-  }
-
-  i2c_dev = new Adafruit_I2CDevice(i2c_addr, wire);
+  releaseBus();
+  i2c_dev = new (&_bus.i2c) Adafruit_I2CDevice(i2c_addr, wire);
 
   if (!i2c_dev->begin()) {
     return false;
@@ -69,7 +134,9 @@ bool Adafruit_PCM51xx::begin(uint8_t i2c_addr, TwoWire* wire) {
 
   return _init();
 }
+#endif
 
+#ifndef PCM51XX_I2C_ONLY
 /*!
  * @brief Initialize the PCM512x with hardware SPI
  * @param cs_pin Chip select pin
@@ -77,16 +144,9 @@ bool Adafruit_PCM51xx::begin(uint8_t i2c_addr, TwoWire* wire) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::begin(int8_t cs_pin, SPIClass* theSPI) {
-  if (i2c_dev) {
-    delete i2c_dev;
-    i2c_dev = nullptr;
-  }
-  if (spi_dev) {
-    delete spi_dev;
-  }
-
-  spi_dev = new Adafruit_SPIDevice(cs_pin, 1000000, SPI_BITORDER_MSBFIRST,
-                                   SPI_MODE0, theSPI);
+  releaseBus();
+  spi_dev = new (&_bus.spi) Adafruit_SPIDevice(
+      cs_pin, 1000000, SPI_BITORDER_MSBFIRST, SPI_MODE0, theSPI);
 
   if (!spi_dev->begin()) {
     return false;
@@ -105,16 +165,10 @@ bool Adafruit_PCM51xx::begin(int8_t cs_pin, SPIClass* theSPI) {
  */
 bool Adafruit_PCM51xx::begin(int8_t cs_pin, int8_t mosi_pin, int8_t miso_pin,
                              int8_t sclk_pin) {
-  if (i2c_dev) {
-    delete i2c_dev;
-    i2c_dev = nullptr;
-  }
-  if (spi_dev) {
-    delete spi_dev;
-  }
-
-  spi_dev = new Adafruit_SPIDevice(cs_pin, sclk_pin, miso_pin, mosi_pin,
-                                   1000000, SPI_BITORDER_MSBFIRST, SPI_MODE0);
+  releaseBus();
+  spi_dev = new (&_bus.spi)
+      Adafruit_SPIDevice(cs_pin, sclk_pin, miso_pin, mosi_pin, 1000000,
+                         SPI_BITORDER_MSBFIRST, SPI_MODE0);
 
   if (!spi_dev->begin()) {
     return false;
@@ -122,57 +176,119 @@ bool Adafruit_PCM51xx::begin(int8_t cs_pin, int8_t mosi_pin, int8_t miso_pin,
 
   return _init();
 }
+#endif
+
+/*!
+ * @brief Register image written by begin() on top of the reset defaults
+ *
+ * Standby/powerdown released, both channels muted, PLL enabled with BCK as
+ * reference and feeding the DAC, every clock error ignored except for
+ * clock autoset, I2S 16-bit and auto mute off.
+ */
+static const pcm51xx_reg_write_t pcm51xx_boot_image[] = {
+    {0, PCM51XX_REG_STANDBY, 0xFF, 0x00},
+    {0, PCM51XX_REG_MUTE, 0xFF, 0x11},
+    {0, PCM51XX_REG_PLL, 0xFF, 0x01},
+    {0, PCM51XX_REG_PLL_REF, 0xFF, 0x10},
+    {0, PCM51XX_REG_DAC_CLK_SRC, 0xFF, 0x10},
+    {0, PCM51XX_REG_ERROR_DETECT, 0xFF, 0x7D},
+    {0, PCM51XX_REG_I2S_CONFIG, 0xFF, 0x00},
+    {0, PCM51XX_REG_AUTO_MUTE, 0xFF, 0x00},
+};
 
 /*!
  * @brief Common initialization routine
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::_init(void) {
+  PCM51XX_TIME_API(PCM51XX_API_BEGIN);
+  uint32_t start = micros();
+  uint32_t transactions = _bus_stats.transactions;
+
   // Force page selection to be set initially
   _page = 0xFF; // Invalid page to force selection
-  if (!selectPage(0)) {
-    return false;
-  }
+  invalidateCache();
+  _clock_plan_valid = false;
+  _reset_check = false;
 
   // Put device into standby before reset operations
-  if (!standby(true)) {
+  if (!writeRegister(0, PCM51XX_REG_STANDBY, 0x10)) {
     return false;
   }
 
-  // Reset registers first
-  if (!resetRegisters()) {
+  // Reset registers and modules together, then wait for both bits to clear
+  const uint8_t both = PCM51XX_FIELD_RESET_MODULES::mask() |
+                       PCM51XX_FIELD_RESET_REGISTERS::mask();
+  if (!writeRegister(0, PCM51XX_REG_RESET, both)) {
     return false;
   }
-
-  // Reset modules
-  if (!resetModules()) {
+  invalidateCache();
+  if (!waitForClear(0, PCM51XX_REG_RESET, both)) {
     return false;
   }
 
-  // Make sure we're out of powerdown mode
-  if (!powerdown(false)) {
-    return false;
+  // Everything else is a single precomputed image, sent as a few bursts
+  const uint8_t image_len =
+      sizeof(pcm51xx_boot_image) / sizeof(pcm51xx_boot_image[0]);
+  Adafruit_PCM51xx_Transaction txn;
+  for (uint8_t i = 0; i < image_len; i++) {
+    const pcm51xx_reg_write_t* w = &pcm51xx_boot_image[i];
+    txn.update(w->page, w->reg, w->mask, w->value);
   }
-
-  // Make sure we're out of standby mode
-  if (!standby(false)) {
+  if (!commit(&txn)) {
     return false;
   }
 
-  // Configure error detection and default settings
-  if (!ignoreFSDetect(true) || !ignoreBCKDetect(true) ||
-      !ignoreSCKDetect(true) || !ignoreClockHalt(true) ||
-      !ignoreClockMissing(true) || !disableClockAutoset(false) ||
-      !ignorePLLUnlock(true) || !enablePLL(true) ||
-      !setPLLReference(PCM51XX_PLL_REF_BCK) ||
-      !setDACSource(PCM51XX_DAC_CLK_PLL) ||
-      !setI2SFormat(PCM51XX_I2S_FORMAT_I2S) ||
-      !setI2SSize(PCM51XX_I2S_SIZE_16BIT) || !setAutoMute(false) ||
-      !mute(true)) {
-    return false;
+  _boot_time = micros() - start;
+  _boot_transactions = _bus_stats.transactions - transactions;
+  return true;
+}
+
+/*!
+ * @brief Get how long the last successful begin() took to bring up the chip
+ * @return Boot duration in microseconds
+ */
+uint32_t Adafruit_PCM51xx::getBootTime(void) {
+  return _boot_time;
+}
+
+/*!
+ * @brief Get how many bus transactions the last successful begin() used
+ * @return Number of bus transactions, including page selects and polls
+ */
+uint32_t Adafruit_PCM51xx::getBootTransactions(void) {
+  return _boot_transactions;
+}
+
+/*!
+ * @brief Poll a register until the requested self-clearing bits clear
+ *
+ * The chip usually finishes a reset or buffer swap well within a
+ * millisecond, so polls start 10us apart and back off exponentially up to
+ * 1ms.
+ *
+ * @param page Register page
+ * @param reg Register address
+ * @param mask Bits to wait for (RSTM is bit 4, RSTR is bit 0 of the reset
+ *        register)
+ * @return True if the bits cleared, false on timeout (100ms) or error
+ */
+bool Adafruit_PCM51xx::waitForClear(uint8_t page, uint8_t reg, uint8_t mask) {
+  uint32_t start = micros();
+  uint16_t backoff = 10;
+
+  while (micros() - start < 100000) {
+    uint8_t value;
+    if (readRegister(page, reg, &value) && !(value & mask)) {
+      return true; // Bits cleared
+    }
+    delayMicroseconds(backoff);
+    if (backoff < 1000) {
+      backoff *= 2;
+    }
   }
 
-  return true;
+  return false; // Timeout
 }
 
 /*!
@@ -180,30 +296,14 @@ bool Adafruit_PCM51xx::_init(void) {
  * @return True if successful, false if timeout or error
  */
 bool Adafruit_PCM51xx::resetModules(void) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register reset_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_RESET, 1);
-  Adafruit_BusIO_RegisterBits rstm_bit =
-      Adafruit_BusIO_RegisterBits(&reset_reg, 1, 4);
-
   // Set the RSTM bit to initiate reset
-  if (!rstm_bit.write(1)) {
+  if (!writeField<PCM51XX_FIELD_RESET_MODULES>(1)) {
     return false;
   }
 
   // Wait for auto-clearing with timeout (max 100ms)
-  uint32_t start = millis();
-  while (millis() - start < 100) {
-    if (rstm_bit.read() == 0) {
-      return true; // Reset completed
-    }
-    delay(1);
-  }
-
-  return false; // Timeout
+  return waitForClear(0, PCM51XX_REG_RESET,
+                      PCM51XX_FIELD_RESET_MODULES::mask());
 }
 
 /*!
@@ -211,30 +311,124 @@ bool Adafruit_PCM51xx::resetModules(void) {
  * @return True if successful, false if timeout or error
  */
 bool Adafruit_PCM51xx::resetRegisters(void) {
-  if (!selectPage(0)) {
+  // Set the RSTR bit to initiate reset
+  if (!writeField<PCM51XX_FIELD_RESET_REGISTERS>(1)) {
     return false;
   }
 
-  Adafruit_BusIO_Register reset_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_RESET, 1);
-  Adafruit_BusIO_RegisterBits rstr_bit =
-      Adafruit_BusIO_RegisterBits(&reset_reg, 1, 0);
+  // Every register is going back to its default, drop the shadow copy
+  invalidateCache();
+  _clock_plan_valid = false;
 
-  // Set the RSTR bit to initiate reset
-  if (!rstr_bit.write(1)) {
-    return false;
+  // Wait for auto-clearing with timeout (max 100ms)
+  return waitForClear(0, PCM51XX_REG_RESET,
+                      PCM51XX_FIELD_RESET_REGISTERS::mask());
+}
+
+/*!
+ * @brief Start a reset or power state transition without waiting for it
+ *
+ * Issues the request and returns right away. Call pollOperation() from the
+ * main loop until it stops returning PCM51XX_OP_BUSY. Only one operation
+ * is tracked at a time; starting another replaces it.
+ *
+ * @param op Operation to start
+ * @param timeout_ms Time after which pollOperation() gives up
+ * @return True if the operation was started, false on error
+ */
+bool Adafruit_PCM51xx::startOperation(pcm51xx_op_t op, uint16_t timeout_ms) {
+  bool ok;
+  switch (op) {
+    case PCM51XX_OP_RESET_MODULES:
+      ok = writeField<PCM51XX_FIELD_RESET_MODULES>(1);
+      break;
+    case PCM51XX_OP_RESET_REGISTERS:
+      ok = writeField<PCM51XX_FIELD_RESET_REGISTERS>(1);
+      invalidateCache();
+      _clock_plan_valid = false;
+      break;
+    case PCM51XX_OP_EXIT_STANDBY:
+      ok = standby(false);
+      break;
+    case PCM51XX_OP_EXIT_POWERDOWN:
+      ok = powerdown(false);
+      break;
+    case PCM51XX_OP_WAIT_PLAYING:
+      ok = true;
+      break;
+    default:
+      return false;
   }
 
-  // Wait for auto-clearing with timeout (max 100ms)
-  uint32_t start = millis();
-  while (millis() - start < 100) {
-    if (rstr_bit.read() == 0) {
-      return true; // Reset completed
+  _op.op = op;
+  _op.status = ok ? PCM51XX_OP_BUSY : PCM51XX_OP_ERROR;
+  _op.polls = 0;
+  _op.elapsed = 0;
+  _op_start = _op_last = micros();
+  _op_timeout = timeout_ms * 1000UL;
+  _op_wait = 0;
+  return ok;
+}
+
+/*!
+ * @brief Advance the current non-blocking operation
+ *
+ * Does at most one status read per call. Reads start 10us apart and back
+ * off exponentially up to 1ms like the blocking resets, and calls made
+ * before the next read is due return without touching the bus.
+ *
+ * @return PCM51XX_OP_BUSY while in progress, otherwise the final status
+ */
+pcm51xx_op_status_t Adafruit_PCM51xx::pollOperation(void) {
+  PCM51XX_TIME_API(PCM51XX_API_POLL);
+  if (_op.status != PCM51XX_OP_BUSY) {
+    return _op.status;
+  }
+
+  uint32_t now = micros();
+  if (now - _op_last < _op_wait) {
+    return PCM51XX_OP_BUSY;
+  }
+
+  bool done = false;
+  uint8_t value;
+  _op.polls++;
+  if (_op.op == PCM51XX_OP_RESET_MODULES ||
+      _op.op == PCM51XX_OP_RESET_REGISTERS) {
+    uint8_t mask = _op.op == PCM51XX_OP_RESET_MODULES
+                       ? PCM51XX_FIELD_RESET_MODULES::mask()
+                       : PCM51XX_FIELD_RESET_REGISTERS::mask();
+    done = readRegister(0, PCM51XX_REG_RESET, &value) && !(value & mask);
+  } else if (readField<PCM51XX_FIELD_POWER_STATE>(&value)) {
+    uint8_t state = value;
+    if (_op.op == PCM51XX_OP_EXIT_STANDBY) {
+      done = state != PCM51XX_POWER_STANDBY;
+    } else if (_op.op == PCM51XX_OP_EXIT_POWERDOWN) {
+      done = state != PCM51XX_POWER_POWERDOWN;
+    } else {
+      done = state == PCM51XX_POWER_RUN_PLAYING;
     }
-    delay(1);
   }
 
-  return false; // Timeout
+  now = micros();
+  _op.elapsed = now - _op_start;
+  if (done) {
+    _op.status = PCM51XX_OP_DONE;
+  } else if (_op.elapsed >= _op_timeout) {
+    _op.status = PCM51XX_OP_TIMEOUT;
+  } else {
+    _op_last = now;
+    _op_wait = _op_wait ? min(_op_wait * 2, 1000) : 10;
+  }
+  return _op.status;
+}
+
+/*!
+ * @brief Get the progress of the last non-blocking operation
+ * @return Operation, status, number of status reads and elapsed time
+ */
+pcm51xx_op_info_t Adafruit_PCM51xx::getOperation(void) {
+  return _op;
 }
 
 /*!
@@ -243,16 +437,7 @@ bool Adafruit_PCM51xx::resetRegisters(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::standby(bool enable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register standby_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_STANDBY, 1);
-  Adafruit_BusIO_RegisterBits rqst_bit =
-      Adafruit_BusIO_RegisterBits(&standby_reg, 1, 4);
-
-  return rqst_bit.write(enable ? 1 : 0);
+  return writeField<PCM51XX_FIELD_STANDBY>(enable ? 1 : 0);
 }
 
 /*!
@@ -260,16 +445,12 @@ bool Adafruit_PCM51xx::standby(bool enable) {
  * @return True if in standby mode, false otherwise
  */
 bool Adafruit_PCM51xx::isStandby(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_STANDBY>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register standby_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_STANDBY, 1);
-  Adafruit_BusIO_RegisterBits rqst_bit =
-      Adafruit_BusIO_RegisterBits(&standby_reg, 1, 4);
-
-  return rqst_bit.read() == 1;
+  return value == 1;
 }
 
 /*!
@@ -278,16 +459,7 @@ bool Adafruit_PCM51xx::isStandby(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::powerdown(bool enable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register standby_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_STANDBY, 1);
-  Adafruit_BusIO_RegisterBits rqpd_bit =
-      Adafruit_BusIO_RegisterBits(&standby_reg, 1, 0);
-
-  return rqpd_bit.write(enable ? 1 : 0);
+  return writeField<PCM51XX_FIELD_POWERDOWN>(enable ? 1 : 0);
 }
 
 /*!
@@ -295,16 +467,12 @@ bool Adafruit_PCM51xx::powerdown(bool enable) {
  * @return True if in powerdown mode, false otherwise
  */
 bool Adafruit_PCM51xx::isPowerdown(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_POWERDOWN>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register standby_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_STANDBY, 1);
-  Adafruit_BusIO_RegisterBits rqpd_bit =
-      Adafruit_BusIO_RegisterBits(&standby_reg, 1, 0);
-
-  return rqpd_bit.read() == 1;
+  return value == 1;
 }
 
 /*!
@@ -313,16 +481,7 @@ bool Adafruit_PCM51xx::isPowerdown(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setI2SFormat(pcm51xx_i2s_format_t format) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register i2s_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_I2S_CONFIG, 1);
-  Adafruit_BusIO_RegisterBits format_bits =
-      Adafruit_BusIO_RegisterBits(&i2s_reg, 2, 4);
-
-  return format_bits.write((uint8_t)format);
+  return writeField<PCM51XX_FIELD_I2S_FORMAT>((uint8_t)format);
 }
 
 /*!
@@ -330,16 +489,12 @@ bool Adafruit_PCM51xx::setI2SFormat(pcm51xx_i2s_format_t format) {
  * @return Current I2S format
  */
 pcm51xx_i2s_format_t Adafruit_PCM51xx::getI2SFormat(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_I2S_FORMAT>(&value)) {
     return PCM51XX_I2S_FORMAT_I2S;
   }
 
-  Adafruit_BusIO_Register i2s_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_I2S_CONFIG, 1);
-  Adafruit_BusIO_RegisterBits format_bits =
-      Adafruit_BusIO_RegisterBits(&i2s_reg, 2, 4);
-
-  return (pcm51xx_i2s_format_t)format_bits.read();
+  return (pcm51xx_i2s_format_t)value;
 }
 
 /*!
@@ -348,16 +503,7 @@ pcm51xx_i2s_format_t Adafruit_PCM51xx::getI2SFormat(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setI2SSize(pcm51xx_i2s_size_t size) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register i2s_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_I2S_CONFIG, 1);
-  Adafruit_BusIO_RegisterBits size_bits =
-      Adafruit_BusIO_RegisterBits(&i2s_reg, 2, 0);
-
-  return size_bits.write((uint8_t)size);
+  return writeField<PCM51XX_FIELD_I2S_SIZE>((uint8_t)size);
 }
 
 /*!
@@ -365,16 +511,12 @@ bool Adafruit_PCM51xx::setI2SSize(pcm51xx_i2s_size_t size) {
  * @return Current I2S word length
  */
 pcm51xx_i2s_size_t Adafruit_PCM51xx::getI2SSize(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_I2S_SIZE>(&value)) {
     return PCM51XX_I2S_SIZE_24BIT;
   }
 
-  Adafruit_BusIO_Register i2s_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_I2S_CONFIG, 1);
-  Adafruit_BusIO_RegisterBits size_bits =
-      Adafruit_BusIO_RegisterBits(&i2s_reg, 2, 0);
-
-  return (pcm51xx_i2s_size_t)size_bits.read();
+  return (pcm51xx_i2s_size_t)value;
 }
 
 /*!
@@ -383,16 +525,7 @@ pcm51xx_i2s_size_t Adafruit_PCM51xx::getI2SSize(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setPLLReference(pcm51xx_pll_ref_t ref) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register pll_ref_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PLL_REF, 1);
-  Adafruit_BusIO_RegisterBits ref_bits =
-      Adafruit_BusIO_RegisterBits(&pll_ref_reg, 3, 4);
-
-  return ref_bits.write((uint8_t)ref);
+  return writeField<PCM51XX_FIELD_PLL_REF>((uint8_t)ref);
 }
 
 /*!
@@ -400,16 +533,12 @@ bool Adafruit_PCM51xx::setPLLReference(pcm51xx_pll_ref_t ref) {
  * @return Current PLL reference clock source
  */
 pcm51xx_pll_ref_t Adafruit_PCM51xx::getPLLReference(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_PLL_REF>(&value)) {
     return PCM51XX_PLL_REF_SCK;
   }
 
-  Adafruit_BusIO_Register pll_ref_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PLL_REF, 1);
-  Adafruit_BusIO_RegisterBits ref_bits =
-      Adafruit_BusIO_RegisterBits(&pll_ref_reg, 3, 4);
-
-  return (pcm51xx_pll_ref_t)ref_bits.read();
+  return (pcm51xx_pll_ref_t)value;
 }
 
 /*!
@@ -419,25 +548,15 @@ pcm51xx_pll_ref_t Adafruit_PCM51xx::getPLLReference(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setVolumeDB(float leftDB, float rightDB) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
+  PCM51XX_TIME_API(PCM51XX_API_SET_VOLUME);
   // Convert dB to register values (0.5dB steps, 0x00 = 24dB, 0xFF = -103.5dB)
   // Formula: regVal = (24.0 - dB) / 0.5
   uint8_t leftVal = (uint8_t)constrain((24.0 - leftDB) / 0.5, 0, 255);
   uint8_t rightVal = (uint8_t)constrain((24.0 - rightDB) / 0.5, 0, 255);
 
-  Adafruit_BusIO_Register left_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DIGITAL_VOLUME_L, 1);
-  Adafruit_BusIO_Register right_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DIGITAL_VOLUME_R, 1);
-
-  if (!left_reg.write(leftVal)) {
-    return false;
-  }
-
-  return right_reg.write(rightVal);
+  // Left and right are adjacent, so both go out in one burst
+  uint8_t values[2] = {leftVal, rightVal};
+  return writeRegisters(0, PCM51XX_REG_DIGITAL_VOLUME_L, values, 2);
 }
 
 /*!
@@ -446,24 +565,269 @@ bool Adafruit_PCM51xx::setVolumeDB(float leftDB, float rightDB) {
  * @param rightDB Pointer to store right channel volume in dB
  */
 void Adafruit_PCM51xx::getVolumeDB(float* leftDB, float* rightDB) {
-  if (!selectPage(0)) {
+  PCM51XX_TIME_API(PCM51XX_API_GET_VOLUME);
+  uint8_t values[2];
+  if (!readRegisters(0, PCM51XX_REG_DIGITAL_VOLUME_L, values, 2)) {
     *leftDB = 0.0;
     *rightDB = 0.0;
     return;
   }
 
-  Adafruit_BusIO_Register left_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DIGITAL_VOLUME_L, 1);
-  Adafruit_BusIO_Register right_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DIGITAL_VOLUME_R, 1);
-
-  uint8_t leftVal = left_reg.read();
-  uint8_t rightVal = right_reg.read();
-
   // Convert register values back to dB
   // Formula: dB = 24.0 - (regVal * 0.5)
-  *leftDB = 24.0 - (leftVal * 0.5);
-  *rightDB = 24.0 - (rightVal * 0.5);
+  *leftDB = 24.0 - (values[0] * 0.5);
+  *rightDB = 24.0 - (values[1] * 0.5);
+}
+
+/*!
+ * @brief Set volume in half-dB steps for both channels
+ *
+ * Integer-only alternative to setVolumeDB(). With the cache enabled, a
+ * channel whose register already holds the value is not written, so only
+ * the register that changed goes out.
+ *
+ * @param left Left channel volume in 0.5dB steps (-207 to 48)
+ * @param right Right channel volume in 0.5dB steps (-207 to 48)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setVolumeHalfDB(int16_t left, int16_t right) {
+  PCM51XX_TIME_API(PCM51XX_API_SET_VOLUME);
+  uint8_t values[2] = {pcm51xx_half_db_to_reg(left),
+                       pcm51xx_half_db_to_reg(right)};
+  uint8_t current;
+  bool left_same = peekCache(0, PCM51XX_REG_DIGITAL_VOLUME_L, &current) &&
+                   current == values[0];
+  bool right_same = peekCache(0, PCM51XX_REG_DIGITAL_VOLUME_R, &current) &&
+                    current == values[1];
+
+  if (left_same && right_same) {
+    return true;
+  }
+  if (left_same) {
+    return writeRegister(0, PCM51XX_REG_DIGITAL_VOLUME_R, values[1]);
+  }
+  if (right_same) {
+    return writeRegister(0, PCM51XX_REG_DIGITAL_VOLUME_L, values[0]);
+  }
+  return writeRegisters(0, PCM51XX_REG_DIGITAL_VOLUME_L, values, 2);
+}
+
+/*!
+ * @brief Set the left channel volume in half-dB steps
+ * @param left Left channel volume in 0.5dB steps (-207 to 48)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setLeftVolumeHalfDB(int16_t left) {
+  PCM51XX_TIME_API(PCM51XX_API_SET_VOLUME);
+  uint8_t value = pcm51xx_half_db_to_reg(left);
+  uint8_t current;
+  if (peekCache(0, PCM51XX_REG_DIGITAL_VOLUME_L, &current) &&
+      current == value) {
+    return true;
+  }
+  return writeRegister(0, PCM51XX_REG_DIGITAL_VOLUME_L, value);
+}
+
+/*!
+ * @brief Set the right channel volume in half-dB steps
+ * @param right Right channel volume in 0.5dB steps (-207 to 48)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setRightVolumeHalfDB(int16_t right) {
+  PCM51XX_TIME_API(PCM51XX_API_SET_VOLUME);
+  uint8_t value = pcm51xx_half_db_to_reg(right);
+  uint8_t current;
+  if (peekCache(0, PCM51XX_REG_DIGITAL_VOLUME_R, &current) &&
+      current == value) {
+    return true;
+  }
+  return writeRegister(0, PCM51XX_REG_DIGITAL_VOLUME_R, value);
+}
+
+/*!
+ * @brief Get volume in half-dB steps for both channels
+ * @param left Pointer to store the left channel volume in 0.5dB steps
+ * @param right Pointer to store the right channel volume in 0.5dB steps
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::getVolumeHalfDB(int16_t* left, int16_t* right) {
+  PCM51XX_TIME_API(PCM51XX_API_GET_VOLUME);
+  uint8_t values[2];
+  if (!readRegisters(0, PCM51XX_REG_DIGITAL_VOLUME_L, values, 2)) {
+    return false;
+  }
+
+  *left = pcm51xx_reg_to_half_db(values[0]);
+  *right = pcm51xx_reg_to_half_db(values[1]);
+  return true;
+}
+
+/*!
+ * @brief Configure the hardware volume ramp
+ *
+ * The chip ramps between volume settings, on mute and unmute, at this
+ * speed. Each step moves the volume by the step size, so a full ramp takes
+ * (volume change / step) * samples per step sample periods.
+ *
+ * @param down_rate Samples per step when the volume goes down
+ * @param down_step Step size when the volume goes down
+ * @param up_rate Samples per step when the volume goes up
+ * @param up_step Step size when the volume goes up
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setVolumeRamp(pcm51xx_ramp_rate_t down_rate,
+                                     pcm51xx_ramp_step_t down_step,
+                                     pcm51xx_ramp_rate_t up_rate,
+                                     pcm51xx_ramp_step_t up_step) {
+  uint8_t value = ((down_rate & 0x03) << 6) | ((down_step & 0x03) << 4) |
+                  ((up_rate & 0x03) << 2) | (up_step & 0x03);
+  return writeRegister(0, PCM51XX_REG_VOLUME_FADE, value);
+}
+
+/*!
+ * @brief Configure the emergency ramp used when a clock error mutes the DAC
+ * @param rate Samples per step
+ * @param step Step size
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setEmergencyRamp(pcm51xx_ramp_rate_t rate,
+                                        pcm51xx_ramp_step_t step) {
+  return writeField<PCM51XX_FIELD_EMERGENCY_RAMP>(((rate & 0x03) << 2) |
+                                                 (step & 0x03));
+}
+
+/*!
+ * @brief Volume register value part way through a fade
+ * @param from Start register value
+ * @param to Target register value
+ * @param t Fade progress (0.0 - 1.0)
+ * @param curve Fade curve
+ * @return Volume register value (0x00 = 24dB, 0xFF = mute)
+ */
+static uint8_t fadeValue(uint8_t from, uint8_t to, float t,
+                         pcm51xx_fade_curve_t curve) {
+  if (curve == PCM51XX_FADE_AMPLITUDE) {
+    // Interpolate linear gain, register 0xFF being silence
+    float from_gain = from == 0xFF ? 0 : pow(10, (24.0 - from * 0.5) / 20);
+    float to_gain = to == 0xFF ? 0 : pow(10, (24.0 - to * 0.5) / 20);
+    float gain = from_gain + (to_gain - from_gain) * t;
+    if (gain <= 0) {
+      return 0xFF;
+    }
+    return (uint8_t)constrain(round((24.0 - 20 * log10(gain)) / 0.5), 0, 255);
+  }
+
+  if (curve == PCM51XX_FADE_SMOOTH) {
+    t = t * t * (3 - 2 * t);
+  }
+  return (uint8_t)round(from + ((int16_t)to - from) * t);
+}
+
+/*!
+ * @brief Start a time-based software fade to a new volume
+ *
+ * Call updateFade() from the main loop until it returns false. Every step
+ * is a single 2-byte burst to both volume registers, and steps are at
+ * least setFadeStepInterval() apart, so a fade never uses more bus time
+ * than that allows; with a short interval each step is one 0.5dB register
+ * step, with a longer one steps get coarser but the duration is kept. The
+ * hardware ramp from setVolumeRamp() smooths each step on the chip.
+ *
+ * @param leftDB Target left channel volume in dB (-103.5 to 24.0 dB)
+ * @param rightDB Target right channel volume in dB (-103.5 to 24.0 dB)
+ * @param duration_ms Fade duration in milliseconds
+ * @param curve Fade curve
+ * @return True if the fade was started, false on error
+ */
+bool Adafruit_PCM51xx::startFade(float leftDB, float rightDB,
+                                 uint16_t duration_ms,
+                                 pcm51xx_fade_curve_t curve) {
+  if (!readRegisters(0, PCM51XX_REG_DIGITAL_VOLUME_L, _fade_from, 2)) {
+    _fading = false;
+    return false;
+  }
+
+  _fade_to[0] = (uint8_t)constrain((24.0 - leftDB) / 0.5, 0, 255);
+  _fade_to[1] = (uint8_t)constrain((24.0 - rightDB) / 0.5, 0, 255);
+  memcpy(_fade_last, _fade_from, 2);
+
+  uint8_t steps = max(abs((int16_t)_fade_to[0] - _fade_from[0]),
+                      abs((int16_t)_fade_to[1] - _fade_from[1]));
+  _fade_curve = curve;
+  _fade_duration = duration_ms * 1000UL;
+  _fade_interval = steps ? _fade_duration / steps : 0;
+  if (_fade_interval < _fade_min_interval) {
+    _fade_interval = _fade_min_interval;
+  }
+  _fade_start = _fade_last_step = micros();
+  _fading = steps != 0;
+  return true;
+}
+
+/*!
+ * @brief Advance the software fade
+ *
+ * Writes at most one volume step per call, and nothing until the next
+ * step is due.
+ *
+ * @return True while the fade is still in progress, false once it is done
+ *         or on error
+ */
+bool Adafruit_PCM51xx::updateFade(void) {
+  PCM51XX_TIME_API(PCM51XX_API_FADE);
+  if (!_fading) {
+    return false;
+  }
+
+  uint32_t now = micros();
+  if (now - _fade_last_step < _fade_interval) {
+    return true;
+  }
+
+  uint32_t elapsed = now - _fade_start;
+  bool last = elapsed >= _fade_duration;
+  float t = last ? 1.0 : (float)elapsed / _fade_duration;
+  uint8_t values[2] = {fadeValue(_fade_from[0], _fade_to[0], t, _fade_curve),
+                       fadeValue(_fade_from[1], _fade_to[1], t, _fade_curve)};
+
+  if (memcmp(values, _fade_last, 2)) {
+    if (!writeRegisters(0, PCM51XX_REG_DIGITAL_VOLUME_L, values, 2)) {
+      _fading = false;
+      return false;
+    }
+    memcpy(_fade_last, values, 2);
+    _fade_last_step = now;
+  }
+
+  _fading = !last;
+  return _fading;
+}
+
+/*!
+ * @brief Check if a software fade is in progress
+ * @return True if fading, false otherwise
+ */
+bool Adafruit_PCM51xx::isFading(void) {
+  return _fading;
+}
+
+/*!
+ * @brief Stop the software fade at the volume reached so far
+ */
+void Adafruit_PCM51xx::stopFade(void) {
+  _fading = false;
+}
+
+/*!
+ * @brief Set the shortest time between two software fade steps
+ *
+ * Bounds the bus time a fade can use: each step is one 2-byte register
+ * burst, about 0.4ms on 100kHz I2C.
+ *
+ * @param min_us Minimum step interval in microseconds (default 2000)
+ */
+void Adafruit_PCM51xx::setFadeStepInterval(uint16_t min_us) {
+  _fade_min_interval = min_us;
 }
 
 /*!
@@ -471,16 +835,12 @@ void Adafruit_PCM51xx::getVolumeDB(float* leftDB, float* rightDB) {
  * @return True if DSP boot is complete, false otherwise
  */
 bool Adafruit_PCM51xx::getDSPBootDone(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_DSP_BOOT_DONE>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register power_state_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_POWER_STATE, 1);
-  Adafruit_BusIO_RegisterBits boot_done_bit =
-      Adafruit_BusIO_RegisterBits(&power_state_reg, 1, 7);
-
-  return boot_done_bit.read() == 1;
+  return value == 1;
 }
 
 /*!
@@ -488,16 +848,12 @@ bool Adafruit_PCM51xx::getDSPBootDone(void) {
  * @return Current power state
  */
 pcm51xx_power_state_t Adafruit_PCM51xx::getPowerState(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_POWER_STATE>(&value)) {
     return PCM51XX_POWER_POWERDOWN;
   }
 
-  Adafruit_BusIO_Register power_state_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_POWER_STATE, 1);
-  Adafruit_BusIO_RegisterBits power_state_bits =
-      Adafruit_BusIO_RegisterBits(&power_state_reg, 4, 0);
-
-  return (pcm51xx_power_state_t)power_state_bits.read();
+  return (pcm51xx_power_state_t)value;
 }
 
 /*!
@@ -506,16 +862,7 @@ pcm51xx_power_state_t Adafruit_PCM51xx::getPowerState(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::ignoreFSDetect(bool ignore) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits idfs_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 6);
-
-  return idfs_bit.write(ignore ? 1 : 0);
+  return writeField<PCM51XX_FIELD_IGNORE_FS>(ignore ? 1 : 0);
 }
 
 /*!
@@ -524,16 +871,7 @@ bool Adafruit_PCM51xx::ignoreFSDetect(bool ignore) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::ignoreBCKDetect(bool ignore) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits idbk_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 5);
-
-  return idbk_bit.write(ignore ? 1 : 0);
+  return writeField<PCM51XX_FIELD_IGNORE_BCK>(ignore ? 1 : 0);
 }
 
 /*!
@@ -542,16 +880,7 @@ bool Adafruit_PCM51xx::ignoreBCKDetect(bool ignore) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::ignoreSCKDetect(bool ignore) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits idsk_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 4);
-
-  return idsk_bit.write(ignore ? 1 : 0);
+  return writeField<PCM51XX_FIELD_IGNORE_SCK>(ignore ? 1 : 0);
 }
 
 /*!
@@ -560,16 +889,7 @@ bool Adafruit_PCM51xx::ignoreSCKDetect(bool ignore) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::ignoreClockHalt(bool ignore) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits idch_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 3);
-
-  return idch_bit.write(ignore ? 1 : 0);
+  return writeField<PCM51XX_FIELD_IGNORE_CLOCK_HALT>(ignore ? 1 : 0);
 }
 
 /*!
@@ -578,16 +898,7 @@ bool Adafruit_PCM51xx::ignoreClockHalt(bool ignore) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::ignoreClockMissing(bool ignore) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits idcm_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 2);
-
-  return idcm_bit.write(ignore ? 1 : 0);
+  return writeField<PCM51XX_FIELD_IGNORE_CLOCK_MISSING>(ignore ? 1 : 0);
 }
 
 /*!
@@ -596,16 +907,7 @@ bool Adafruit_PCM51xx::ignoreClockMissing(bool ignore) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::disableClockAutoset(bool disable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits dcas_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 1);
-
-  return dcas_bit.write(disable ? 1 : 0);
+  return writeField<PCM51XX_FIELD_DISABLE_AUTOSET>(disable ? 1 : 0);
 }
 
 /*!
@@ -614,16 +916,7 @@ bool Adafruit_PCM51xx::disableClockAutoset(bool disable) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::ignorePLLUnlock(bool ignore) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register error_detect_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_ERROR_DETECT, 1);
-  Adafruit_BusIO_RegisterBits iplk_bit =
-      Adafruit_BusIO_RegisterBits(&error_detect_reg, 1, 0);
-
-  return iplk_bit.write(ignore ? 1 : 0);
+  return writeField<PCM51XX_FIELD_IGNORE_PLL_UNLOCK>(ignore ? 1 : 0);
 }
 
 /*!
@@ -632,16 +925,7 @@ bool Adafruit_PCM51xx::ignorePLLUnlock(bool ignore) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setDACSource(pcm51xx_dac_clk_src_t source) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register dac_clk_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DAC_CLK_SRC, 1);
-  Adafruit_BusIO_RegisterBits sdac_bits =
-      Adafruit_BusIO_RegisterBits(&dac_clk_reg, 3, 4);
-
-  return sdac_bits.write((uint8_t)source);
+  return writeField<PCM51XX_FIELD_DAC_CLK_SRC>((uint8_t)source);
 }
 
 /*!
@@ -649,16 +933,12 @@ bool Adafruit_PCM51xx::setDACSource(pcm51xx_dac_clk_src_t source) {
  * @return Current DAC clock source
  */
 pcm51xx_dac_clk_src_t Adafruit_PCM51xx::getDACSource(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_DAC_CLK_SRC>(&value)) {
     return PCM51XX_DAC_CLK_MASTER;
   }
 
-  Adafruit_BusIO_Register dac_clk_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DAC_CLK_SRC, 1);
-  Adafruit_BusIO_RegisterBits sdac_bits =
-      Adafruit_BusIO_RegisterBits(&dac_clk_reg, 3, 4);
-
-  return (pcm51xx_dac_clk_src_t)sdac_bits.read();
+  return (pcm51xx_dac_clk_src_t)value;
 }
 
 /*!
@@ -667,16 +947,7 @@ pcm51xx_dac_clk_src_t Adafruit_PCM51xx::getDACSource(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setAutoMute(bool enable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register auto_mute_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_AUTO_MUTE, 1);
-  Adafruit_BusIO_RegisterBits auto_mute_bits =
-      Adafruit_BusIO_RegisterBits(&auto_mute_reg, 3, 0);
-
-  return auto_mute_bits.write(enable ? 0x7 : 0x0);
+  return writeField<PCM51XX_FIELD_AUTO_MUTE>(enable ? 0x7 : 0x0);
 }
 
 /*!
@@ -684,16 +955,11 @@ bool Adafruit_PCM51xx::setAutoMute(bool enable) {
  * @return True if auto mute is enabled, false otherwise
  */
 bool Adafruit_PCM51xx::getAutoMute(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_AUTO_MUTE>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register auto_mute_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_AUTO_MUTE, 1);
-  Adafruit_BusIO_RegisterBits auto_mute_bits =
-      Adafruit_BusIO_RegisterBits(&auto_mute_reg, 3, 0);
-
-  uint8_t value = auto_mute_bits.read();
   return (value == 0x7);
 }
 
@@ -703,23 +969,11 @@ bool Adafruit_PCM51xx::getAutoMute(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::mute(bool enable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register mute_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_MUTE, 1);
-  Adafruit_BusIO_RegisterBits rqml_bit =
-      Adafruit_BusIO_RegisterBits(&mute_reg, 1, 4);
-  Adafruit_BusIO_RegisterBits rqmr_bit =
-      Adafruit_BusIO_RegisterBits(&mute_reg, 1, 0);
-
-  // Set both left (bit 4) and right (bit 0) mute bits
-  if (!rqml_bit.write(enable ? 1 : 0)) {
-    return false;
-  }
-
-  return rqmr_bit.write(enable ? 1 : 0);
+  PCM51XX_TIME_API(PCM51XX_API_MUTE);
+  // Set both left and right mute bits in one write
+  const uint8_t both =
+      PCM51XX_FIELD_MUTE_LEFT::mask() | PCM51XX_FIELD_MUTE_RIGHT::mask();
+  return updateRegister(0, PCM51XX_REG_MUTE, both, enable ? both : 0x00);
 }
 
 /*!
@@ -727,19 +981,14 @@ bool Adafruit_PCM51xx::mute(bool enable) {
  * @return True if both channels are muted, false otherwise
  */
 bool Adafruit_PCM51xx::isMuted(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readRegister(0, PCM51XX_REG_MUTE, &value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register mute_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_MUTE, 1);
-  Adafruit_BusIO_RegisterBits rqml_bit =
-      Adafruit_BusIO_RegisterBits(&mute_reg, 1, 4);
-  Adafruit_BusIO_RegisterBits rqmr_bit =
-      Adafruit_BusIO_RegisterBits(&mute_reg, 1, 0);
-
   // Both channels must be muted to return true
-  return (rqml_bit.read() == 1) && (rqmr_bit.read() == 1);
+  return PCM51XX_FIELD_MUTE_LEFT::get(value) &&
+         PCM51XX_FIELD_MUTE_RIGHT::get(value);
 }
 
 /*!
@@ -748,16 +997,7 @@ bool Adafruit_PCM51xx::isMuted(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::enablePLL(bool enable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register pll_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PLL, 1);
-  Adafruit_BusIO_RegisterBits plle_bit =
-      Adafruit_BusIO_RegisterBits(&pll_reg, 1, 0);
-
-  return plle_bit.write(enable ? 1 : 0);
+  return writeField<PCM51XX_FIELD_PLL_ENABLE>(enable ? 1 : 0);
 }
 
 /*!
@@ -765,16 +1005,12 @@ bool Adafruit_PCM51xx::enablePLL(bool enable) {
  * @return True if PLL is enabled, false otherwise
  */
 bool Adafruit_PCM51xx::isPLLEnabled(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_PLL_ENABLE>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register pll_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PLL, 1);
-  Adafruit_BusIO_RegisterBits plle_bit =
-      Adafruit_BusIO_RegisterBits(&pll_reg, 1, 0);
-
-  return plle_bit.read() == 1;
+  return value == 1;
 }
 
 /*!
@@ -782,16 +1018,12 @@ bool Adafruit_PCM51xx::isPLLEnabled(void) {
  * @return True if PLL is locked, false otherwise
  */
 bool Adafruit_PCM51xx::isPLLLocked(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_PLL_LOCK>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register pll_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PLL, 1);
-  Adafruit_BusIO_RegisterBits pllk_bit =
-      Adafruit_BusIO_RegisterBits(&pll_reg, 1, 4);
-
-  return pllk_bit.read() == 0; // 0 = locked, 1 = not locked
+  return value == 0; // 0 = locked, 1 = not locked
 }
 
 /*!
@@ -800,16 +1032,7 @@ bool Adafruit_PCM51xx::isPLLLocked(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::enableDeemphasis(bool enable) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register deemphasis_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DEEMPHASIS, 1);
-  Adafruit_BusIO_RegisterBits demp_bit =
-      Adafruit_BusIO_RegisterBits(&deemphasis_reg, 1, 4);
-
-  return demp_bit.write(enable ? 1 : 0);
+  return writeField<PCM51XX_FIELD_DEEMPHASIS>(enable ? 1 : 0);
 }
 
 /*!
@@ -817,16 +1040,12 @@ bool Adafruit_PCM51xx::enableDeemphasis(bool enable) {
  * @return True if de-emphasis is enabled, false otherwise
  */
 bool Adafruit_PCM51xx::isDeemphasized(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_DEEMPHASIS>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register deemphasis_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_DEEMPHASIS, 1);
-  Adafruit_BusIO_RegisterBits demp_bit =
-      Adafruit_BusIO_RegisterBits(&deemphasis_reg, 1, 4);
-
-  return demp_bit.read() == 1;
+  return value == 1;
 }
 
 /*!
@@ -839,16 +1058,12 @@ bool Adafruit_PCM51xx::digitalRead(uint8_t pin) {
     return false; // Invalid pin number
   }
 
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_GPIO_INPUT>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register gpio_input_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_GPIO_INPUT, 1);
-  Adafruit_BusIO_RegisterBits gpio_bit =
-      Adafruit_BusIO_RegisterBits(&gpio_input_reg, 1, pin - 1);
-
-  return gpio_bit.read() == 1;
+  return (value >> (pin - 1)) & 1;
 }
 
 /*!
@@ -857,17 +1072,7 @@ bool Adafruit_PCM51xx::digitalRead(uint8_t pin) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::enableVCOM(bool enable) {
-  if (!selectPage(1)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register output_amp_reg =
-      Adafruit_BusIO_Register(i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD,
-                              PCM51XX_REG_PAGE1_OUTPUT_AMP_TYPE, 1);
-  Adafruit_BusIO_RegisterBits osel_bit =
-      Adafruit_BusIO_RegisterBits(&output_amp_reg, 1, 0);
-
-  return osel_bit.write(enable ? 1 : 0);
+  return writeField<PCM51XX_FIELD_OUTPUT_AMP_TYPE>(enable ? 1 : 0);
 }
 
 /*!
@@ -875,17 +1080,12 @@ bool Adafruit_PCM51xx::enableVCOM(bool enable) {
  * @return True if VCOM mode is enabled, false if VREF mode
  */
 bool Adafruit_PCM51xx::isVCOMEnabled(void) {
-  if (!selectPage(1)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_OUTPUT_AMP_TYPE>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register output_amp_reg =
-      Adafruit_BusIO_Register(i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD,
-                              PCM51XX_REG_PAGE1_OUTPUT_AMP_TYPE, 1);
-  Adafruit_BusIO_RegisterBits osel_bit =
-      Adafruit_BusIO_RegisterBits(&output_amp_reg, 1, 0);
-
-  return osel_bit.read() == 1;
+  return value == 1;
 }
 
 /*!
@@ -894,16 +1094,8 @@ bool Adafruit_PCM51xx::isVCOMEnabled(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setVCOMPower(bool enable) {
-  if (!selectPage(1)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register vcom_power_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PAGE1_VCOM_POWER, 1);
-  Adafruit_BusIO_RegisterBits vcpd_bit =
-      Adafruit_BusIO_RegisterBits(&vcom_power_reg, 1, 0);
-
-  return vcpd_bit.write(enable ? 0 : 1); // 0 = powered on, 1 = powered down
+  // 0 = powered on, 1 = powered down
+  return writeField<PCM51XX_FIELD_VCOM_POWERDOWN>(enable ? 0 : 1);
 }
 
 /*!
@@ -911,16 +1103,12 @@ bool Adafruit_PCM51xx::setVCOMPower(bool enable) {
  * @return True if VCOM is powered on, false if powered down
  */
 bool Adafruit_PCM51xx::isVCOMPowered(void) {
-  if (!selectPage(1)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_VCOM_POWERDOWN>(&value)) {
     return false;
   }
 
-  Adafruit_BusIO_Register vcom_power_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PAGE1_VCOM_POWER, 1);
-  Adafruit_BusIO_RegisterBits vcpd_bit =
-      Adafruit_BusIO_RegisterBits(&vcom_power_reg, 1, 0);
-
-  return vcpd_bit.read() == 0; // 0 = powered on, 1 = powered down
+  return value == 0; // 0 = powered on, 1 = powered down
 }
 
 /*!
@@ -929,16 +1117,7 @@ bool Adafruit_PCM51xx::isVCOMPowered(void) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_PCM51xx::setGPIO5Output(pcm51xx_gpio5_output_t output) {
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register gpio5_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_GPIO5_OUTPUT, 1);
-  Adafruit_BusIO_RegisterBits gpio5_bits =
-      Adafruit_BusIO_RegisterBits(&gpio5_reg, 5, 0);
-
-  return gpio5_bits.write((uint8_t)output);
+  return writeField<PCM51XX_FIELD_GPIO5_OUTPUT>((uint8_t)output);
 }
 
 /*!
@@ -946,16 +1125,12 @@ bool Adafruit_PCM51xx::setGPIO5Output(pcm51xx_gpio5_output_t output) {
  * @return Current GPIO5 output selection
  */
 pcm51xx_gpio5_output_t Adafruit_PCM51xx::getGPIO5Output(void) {
-  if (!selectPage(0)) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_GPIO5_OUTPUT>(&value)) {
     return PCM51XX_GPIO5_OFF;
   }
 
-  Adafruit_BusIO_Register gpio5_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_GPIO5_OUTPUT, 1);
-  Adafruit_BusIO_RegisterBits gpio5_bits =
-      Adafruit_BusIO_RegisterBits(&gpio5_reg, 5, 0);
-
-  return (pcm51xx_gpio5_output_t)gpio5_bits.read();
+  return (pcm51xx_gpio5_output_t)value;
 }
 
 /*!
@@ -969,16 +1144,7 @@ bool Adafruit_PCM51xx::setGPIODirection(uint8_t gpio, bool output) {
     return false;
   }
 
-  if (!selectPage(0)) {
-    return false;
-  }
-
-  Adafruit_BusIO_Register gpio_enable_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_GPIO_ENABLE, 1);
-  Adafruit_BusIO_RegisterBits gpio_bit =
-      Adafruit_BusIO_RegisterBits(&gpio_enable_reg, 1, gpio - 1);
-
-  return gpio_bit.write(output ? 1 : 0);
+  return writeFieldBit<PCM51XX_FIELD_GPIO_ENABLE>(gpio - 1, output);
 }
 
 /*!
@@ -991,34 +1157,3482 @@ bool Adafruit_PCM51xx::setGPIORegisterOutput(uint8_t gpio, bool high) {
   if (gpio < 1 || gpio > 6) {
     return false;
   }
-  if (!selectPage(0)) {
+  return writeFieldBit<PCM51XX_FIELD_GPIO_CONTROL>(gpio - 1, high);
+}
+
+/*!
+ * @brief Set the output function of a GPIO pin
+ *
+ * Every GPIO offers the same functions as GPIO5. The pin must also be made
+ * an output with setGPIODirection().
+ *
+ * @param gpio GPIO pin number (1-6)
+ * @param output Output selection
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setGPIOOutput(uint8_t gpio,
+                                     pcm51xx_gpio5_output_t output) {
+  if (gpio < 1 || gpio > 6) {
     return false;
   }
+  return updateRegister(0, PCM51XX_REG_GPIO1_OUTPUT + gpio - 1,
+                        PCM51XX_FIELD_GPIO5_OUTPUT::mask(), (uint8_t)output);
+}
+
+/*! @brief GPIO flag output signalling each pcm51xx_event_t */
+static const pcm51xx_gpio5_output_t pcm51xx_event_flags[PCM51XX_EVENT_COUNT] = {
+    PCM51XX_GPIO5_PLL_LOCK, PCM51XX_GPIO5_CLOCK_INVALID,
+    PCM51XX_GPIO5_AUTO_MUTE_FLAG, PCM51XX_GPIO5_UNDER_VOLT_07};
 
-  Adafruit_BusIO_Register gpio_control_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_GPIO_CONTROL, 1);
-  Adafruit_BusIO_RegisterBits gpio_bit =
-      Adafruit_BusIO_RegisterBits(&gpio_control_reg, 1, gpio - 1);
+/*! @brief Chip instance and MCU pin behind each interrupt slot */
+Adafruit_PCM51xx* Adafruit_PCM51xx::_event_owners[PCM51XX_EVENT_PINS];
+uint8_t Adafruit_PCM51xx::_event_pins[PCM51XX_EVENT_PINS];
 
-  return gpio_bit.write(high ? 1 : 0);
+#ifdef IRAM_ATTR
+#define PCM51XX_ISR_ATTR IRAM_ATTR ///< Keep ISRs in IRAM on ESP32
+#else
+#define PCM51XX_ISR_ATTR ///< No ISR placement needed
+#endif
+
+/*!
+ * @brief Interrupt handler for one slot: flags its DAC for handleEvents()
+ *
+ * Arduino interrupt handlers take no argument, so each slot gets its own
+ * instance of this template.
+ */
+template <uint8_t SLOT>
+void PCM51XX_ISR_ATTR Adafruit_PCM51xx::eventISR(void) {
+  _event_owners[SLOT]->_event_pending = true;
 }
 
 /*!
- * @brief Select register page
- * @param page Page number to select (0-255)
+ * @brief Route a status event to a GPIO pin
+ *
+ * The GPIO is made an output carrying the event's flag. Wire it to an MCU
+ * pin passed to attachEventPin() so handleEvents() learns about changes
+ * without polling.
+ *
+ * @param event Event to route
+ * @param gpio GPIO pin number (1-6), or 0 to stop watching the event
  * @return True if successful, false otherwise
  */
-bool Adafruit_PCM51xx::selectPage(uint8_t page) {
-  if (_page == page) {
-    return true; // Already on correct page, skip bus write
+bool Adafruit_PCM51xx::routeEvent(pcm51xx_event_t event, uint8_t gpio) {
+  if (event >= PCM51XX_EVENT_COUNT || gpio > 6) {
+    return false;
   }
 
-  Adafruit_BusIO_Register page_reg = Adafruit_BusIO_Register(
-      i2c_dev, spi_dev, ADDRBIT8_HIGH_TOREAD, PCM51XX_REG_PAGE_SELECT, 1);
-
-  if (page_reg.write(page)) {
-    _page = page; // Update cached page on successful write
+  _event_gpio[event] = 0;
+  _event_active &= ~(1 << event);
+  if (gpio == 0) {
     return true;
   }
+
+  if (!setGPIOOutput(gpio, pcm51xx_event_flags[event]) ||
+      !setGPIODirection(gpio, true)) {
+    return false;
+  }
+  _event_gpio[event] = gpio;
+  // Report a condition that is already present on the next handleEvents()
+  _event_pending = true;
+  return true;
+}
+
+/*!
+ * @brief Set the function called when an event starts or clears
+ * @param event Event to watch
+ * @param callback Function to call from handleEvents(), or nullptr
+ * @return True if successful, false if event is invalid
+ */
+bool Adafruit_PCM51xx::onEvent(pcm51xx_event_t event,
+                               pcm51xx_event_callback_t callback) {
+  if (event >= PCM51XX_EVENT_COUNT) {
+    return false;
+  }
+  _event_callbacks[event] = callback;
+  return true;
+}
+
+/*!
+ * @brief Watch an MCU pin wired to a routed GPIO flag
+ *
+ * Attaches a change interrupt to the pin. The interrupt only marks the DAC
+ * as needing attention; the status is read later by handleEvents(). Up to
+ * PCM51XX_EVENT_PINS pins can be watched across all instances. Attaching
+ * a pin this instance already watches keeps its existing slot.
+ *
+ * @param pin MCU pin number
+ * @return True if successful, false if the pin has no interrupt, is
+ *         watched by another instance or all slots are in use
+ */
+bool Adafruit_PCM51xx::attachEventPin(uint8_t pin) {
+  static void (*const isrs[PCM51XX_EVENT_PINS])(void) = {
+      eventISR<0>, eventISR<1>, eventISR<2>, eventISR<3>};
+
+  int irq = digitalPinToInterrupt(pin);
+#ifdef NOT_AN_INTERRUPT
+  if (irq == NOT_AN_INTERRUPT) {
+    return false;
+  }
+#endif
+
+  // A second slot would attach another ISR to the same interrupt
+  for (uint8_t slot = 0; slot < PCM51XX_EVENT_PINS; slot++) {
+    if (_event_owners[slot] && _event_pins[slot] == pin) {
+      return _event_owners[slot] == this;
+    }
+  }
+
+  for (uint8_t slot = 0; slot < PCM51XX_EVENT_PINS; slot++) {
+    if (!_event_owners[slot]) {
+      _event_owners[slot] = this;
+      _event_pins[slot] = pin;
+      _event_pending = true;
+      pinMode(pin, INPUT);
+      attachInterrupt(irq, isrs[slot], CHANGE);
+      return true;
+    }
+  }
   return false;
-}
\ No newline at end of file
+}
+
+/*!
+ * @brief Stop watching every MCU pin attached by this instance
+ */
+void Adafruit_PCM51xx::detachEventPins(void) {
+  for (uint8_t slot = 0; slot < PCM51XX_EVENT_PINS; slot++) {
+    if (_event_owners[slot] == this) {
+      detachInterrupt(digitalPinToInterrupt(_event_pins[slot]));
+      _event_owners[slot] = nullptr;
+    }
+  }
+}
+
+/*!
+ * @brief Dispatch callbacks for events that changed since the last call
+ *
+ * Call this from loop(). Without a flag pin change it returns at once
+ * with no bus traffic; otherwise a single read of the GPIO input register
+ * gives the level of every routed flag.
+ *
+ * @return Events that started or cleared, bit n = event n
+ */
+uint8_t Adafruit_PCM51xx::handleEvents(void) {
+  if (!_event_pending) {
+    return 0;
+  }
+  // Cleared before reading so an edge during the read is not lost
+  _event_pending = false;
+
+  uint8_t levels;
+  if (!readField<PCM51XX_FIELD_GPIO_INPUT>(&levels)) {
+    _event_pending = true;
+    return 0;
+  }
+
+  uint8_t active = 0;
+  for (uint8_t i = 0; i < PCM51XX_EVENT_COUNT; i++) {
+    if (!_event_gpio[i]) {
+      continue;
+    }
+    bool high = (levels >> (_event_gpio[i] - 1)) & 1;
+    // The PLL flag is high while locked; the others are high when set
+    if (high != (i == PCM51XX_EVENT_PLL_UNLOCK)) {
+      active |= 1 << i;
+    }
+  }
+
+  uint8_t changed = active ^ _event_active;
+  _event_active = active;
+  for (uint8_t i = 0; i < PCM51XX_EVENT_COUNT; i++) {
+    if ((changed >> i) & 1 && _event_callbacks[i]) {
+      _event_callbacks[i]((pcm51xx_event_t)i, (active >> i) & 1);
+    }
+  }
+  return changed;
+}
+
+/*!
+ * @brief Get the events active as of the last handleEvents()
+ * @return Active events, bit n = event n
+ */
+uint8_t Adafruit_PCM51xx::getActiveEvents(void) {
+  return _event_active;
+}
+
+/*!
+ * @brief Search the PLL divider space for the lowest-jitter solution
+ *
+ * Only exact solutions are returned. Integer multipliers (D = 0) are
+ * preferred over fractional ones, then the highest phase detector
+ * frequency (fREF / P), then the smallest R. The PLL input and multiplier
+ * ranges follow the datasheet: fREF / P must be 1-20MHz (6.667-20MHz with
+ * D != 0, which also needs 4 <= J <= 11 and R = 1).
+ *
+ * @param ref_hz PLL reference clock frequency in Hz
+ * @param pll_hz Desired PLL output frequency in Hz
+ * @param pll Pointer to store the divider settings
+ * @return True if a valid solution was found, false otherwise
+ */
+bool Adafruit_PCM51xx::findPLLDividers(uint32_t ref_hz, uint32_t pll_hz,
+                                       pcm51xx_pll_t* pll) {
+  if (ref_hz == 0 || pll_hz < PCM51XX_PLL_MIN_HZ ||
+      pll_hz > PCM51XX_PLL_MAX_HZ) {
+    return false;
+  }
+
+  bool found = false;
+  bool found_integer = false;
+
+  // Lower P means a faster phase detector and less jitter, so stop at the
+  // first P that gives an integer solution
+  for (uint8_t p = 1; p <= 15 && !found_integer; p++) {
+    uint32_t pd_hz = ref_hz / p;
+    if (pd_hz < 1000000UL) {
+      break;
+    }
+    if (pd_hz > 20000000UL) {
+      continue;
+    }
+
+    // R * J.D * 10000 must come out exact
+    uint64_t scaled = (uint64_t)pll_hz * p * 10000;
+    if (scaled % ref_hz) {
+      continue;
+    }
+    uint32_t rjd = scaled / ref_hz;
+
+    for (uint8_t r = 1; r <= 16; r++) {
+      if (rjd % r) {
+        continue;
+      }
+      uint32_t jd = rjd / r;
+      uint32_t j = jd / 10000;
+      uint16_t d = jd % 10000;
+
+      if (d == 0 && j >= 1 && j <= 63) {
+        pll->p = p;
+        pll->j = j;
+        pll->d = 0;
+        pll->r = r;
+        found = found_integer = true;
+        break;
+      }
+      if (!found && d != 0 && r == 1 && j >= 4 && j <= 11 &&
+          pd_hz * 3 >= 20000000UL) {
+        pll->p = p;
+        pll->j = j;
+        pll->d = d;
+        pll->r = r;
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
+
+/*!
+ * @brief Program the PLL P, J, D and R dividers
+ * @param pll Divider settings to write
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setPLLDividers(const pcm51xx_pll_t* pll) {
+  if (pll->p < 1 || pll->p > 15 || pll->j < 1 || pll->j > 63 ||
+      pll->d > 9999 || pll->r < 1 || pll->r > 16) {
+    return false;
+  }
+
+  // P, J, D and R are contiguous, so they go out in one burst
+  uint8_t values[5] = {(uint8_t)(pll->p - 1), pll->j, (uint8_t)(pll->d >> 8),
+                       (uint8_t)(pll->d & 0xFF), (uint8_t)(pll->r - 1)};
+  return writeRegisters(0, PCM51XX_REG_PLL_P, values, 5);
+}
+
+/*!
+ * @brief Read back the PLL P, J, D and R dividers
+ * @param pll Pointer to store the divider settings
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::getPLLDividers(pcm51xx_pll_t* pll) {
+  uint8_t values[5];
+  if (!readRegisters(0, PCM51XX_REG_PLL_P, values, 5)) {
+    return false;
+  }
+
+  pll->p = (values[0] & 0x0F) + 1;
+  pll->j = values[1] & 0x3F;
+  pll->d = ((uint16_t)(values[2] & 0x3F) << 8) | values[3];
+  pll->r = (values[4] & 0x0F) + 1;
+  return true;
+}
+
+/*!
+ * @brief Precomputed PLL settings for common reference/sample rate pairs
+ *
+ * BCK at 64fs and the usual 256fs/512fs master clocks. These are the
+ * solutions findPLLDividers() would pick, so the search only runs for
+ * unusual clocks.
+ */
+static const struct {
+  uint32_t ref_hz;      ///< PLL reference frequency
+  uint32_t sample_rate; ///< Sample rate
+  pcm51xx_pll_t pll;    ///< Divider settings
+} pcm51xx_pll_table[] PROGMEM = {
+    {2822400UL, 44100UL, {1, 32, 0, 1}},
+    {3072000UL, 48000UL, {1, 32, 0, 1}},
+    {5644800UL, 88200UL, {1, 16, 0, 1}},
+    {6144000UL, 96000UL, {1, 16, 0, 1}},
+    {11289600UL, 176400UL, {1, 8, 0, 1}},
+    {12288000UL, 192000UL, {1, 8, 0, 1}},
+    {11289600UL, 44100UL, {1, 8, 0, 1}},
+    {12288000UL, 48000UL, {1, 8, 0, 1}},
+    {22579200UL, 44100UL, {2, 8, 0, 1}},
+    {24576000UL, 48000UL, {2, 8, 0, 1}},
+};
+
+/*!
+ * @brief PLL output frequency for a set of dividers
+ * @param ref_hz PLL reference clock frequency in Hz
+ * @param pll Divider settings
+ * @return fREF * R * J.D / P in Hz
+ */
+static uint32_t pllOutputHz(uint32_t ref_hz, const pcm51xx_pll_t* pll) {
+  return (uint64_t)ref_hz * pll->r * (pll->j * 10000UL + pll->d) /
+         (pll->p * 10000UL);
+}
+
+/*!
+ * @brief Check whether a clock source runs from BCK
+ * @param source DAC clock source
+ * @param pll_ref PLL reference clock source
+ * @return True if the clock feeding the dividers scales with the BCK rate
+ */
+static bool clockFromBCK(pcm51xx_dac_clk_src_t source,
+                         pcm51xx_pll_ref_t pll_ref) {
+  return source == PCM51XX_DAC_CLK_BCK ||
+         (source == PCM51XX_DAC_CLK_PLL && pll_ref == PCM51XX_PLL_REF_BCK);
+}
+
+/*!
+ * @brief Register values for the clock registers 0x14-0x24 of a plan
+ *
+ * Unused addresses in the range are left at 0.
+ *
+ * @param plan Clock plan to encode
+ * @param regs Buffer for PCM51XX_REG_IDAC_LSB - PCM51XX_REG_PLL_P + 1 bytes
+ */
+static void encodeClockPlan(const pcm51xx_clock_plan_t* plan,
+                            uint8_t* regs) {
+  memset(regs, 0, PCM51XX_REG_IDAC_LSB - PCM51XX_REG_PLL_P + 1);
+  if (plan->source == PCM51XX_DAC_CLK_PLL) {
+    const pcm51xx_pll_t* pll = &plan->pll;
+    regs[PCM51XX_REG_PLL_P - PCM51XX_REG_PLL_P] = pll->p - 1;
+    regs[PCM51XX_REG_PLL_J - PCM51XX_REG_PLL_P] = pll->j;
+    regs[PCM51XX_REG_PLL_D_MSB - PCM51XX_REG_PLL_P] = pll->d >> 8;
+    regs[PCM51XX_REG_PLL_D_LSB - PCM51XX_REG_PLL_P] = pll->d & 0xFF;
+    regs[PCM51XX_REG_PLL_R - PCM51XX_REG_PLL_P] = pll->r - 1;
+  }
+  regs[PCM51XX_REG_DSP_CLK_DIV - PCM51XX_REG_PLL_P] = plan->dsp_div - 1;
+  regs[PCM51XX_REG_DAC_CLK_DIV - PCM51XX_REG_PLL_P] = plan->dac_div - 1;
+  regs[PCM51XX_REG_NCP_CLK_DIV - PCM51XX_REG_PLL_P] = plan->ncp_div - 1;
+  regs[PCM51XX_REG_OSR_CLK_DIV - PCM51XX_REG_PLL_P] = plan->osr_div - 1;
+  regs[PCM51XX_REG_FS_SPEED - PCM51XX_REG_PLL_P] = plan->fs_speed;
+  regs[PCM51XX_REG_IDAC_MSB - PCM51XX_REG_PLL_P] = plan->idac >> 8;
+  regs[PCM51XX_REG_IDAC_LSB - PCM51XX_REG_PLL_P] = plan->idac & 0xFF;
+}
+
+/*!
+ * @brief Queue every register write that programs a clock plan
+ *
+ * Turns clock autoset off and sets the clock source, PLL, dividers, speed
+ * mode and IDAC. With autoset off the chip also needs the speed mode and
+ * the number of DSP cycles per sample. Exactly fills a transaction.
+ *
+ * @param plan Clock plan to program
+ * @param txn Empty transaction to queue the writes in
+ * @return True if queued, false if the transaction overflowed
+ */
+static bool queueClockPlan(const pcm51xx_clock_plan_t* plan,
+                           Adafruit_PCM51xx_Transaction* txn) {
+  const uint8_t len = PCM51XX_REG_IDAC_LSB - PCM51XX_REG_PLL_P + 1;
+  uint8_t regs[len];
+  encodeClockPlan(plan, regs);
+
+  bool use_pll = plan->source == PCM51XX_DAC_CLK_PLL;
+  bool ok = txn->writeField<PCM51XX_FIELD_DISABLE_AUTOSET>(1) &&
+            txn->writeField<PCM51XX_FIELD_DAC_CLK_SRC>(plan->source) &&
+            txn->writeField<PCM51XX_FIELD_PLL_ENABLE>(use_pll ? 1 : 0);
+  for (uint8_t reg = PCM51XX_REG_DSP_CLK_DIV;
+       reg <= PCM51XX_REG_IDAC_LSB && ok; reg++) {
+    if (reg <= PCM51XX_REG_OSR_CLK_DIV || reg >= PCM51XX_REG_FS_SPEED) {
+      ok = txn->write(0, reg, regs[reg - PCM51XX_REG_PLL_P]);
+    }
+  }
+  if (use_pll) {
+    ok = ok && txn->writeField<PCM51XX_FIELD_PLL_REF>(plan->pll_ref);
+    for (uint8_t reg = PCM51XX_REG_PLL_P; reg <= PCM51XX_REG_PLL_R && ok;
+         reg++) {
+      ok = txn->write(0, reg, regs[reg - PCM51XX_REG_PLL_P]);
+    }
+  }
+  return ok;
+}
+
+/*!
+ * @brief Pick the PLL dividers for a reference clock and sample rate
+ *
+ * Picks a PLL output that is a multiple of 16fs within the VCO range and
+ * finds the lowest-jitter P/J.D/R for it, from a precomputed table for
+ * common clocks or by search otherwise.
+ *
+ * @param ref_hz PLL reference clock frequency in Hz
+ * @param sample_rate Target sample rate in Hz
+ * @param pll Pointer to store the divider settings
+ * @return True if a valid setting was found, false otherwise
+ */
+bool Adafruit_PCM51xx::planPLL(uint32_t ref_hz, uint32_t sample_rate,
+                               pcm51xx_pll_t* pll) {
+  const uint32_t osr_hz = 16 * sample_rate;
+
+  const uint8_t table_len =
+      sizeof(pcm51xx_pll_table) / sizeof(pcm51xx_pll_table[0]);
+  for (uint8_t i = 0; i < table_len; i++) {
+    uint32_t entry[2];
+    memcpy_P(entry, &pcm51xx_pll_table[i], sizeof(entry));
+    if (entry[0] == ref_hz && entry[1] == sample_rate) {
+      memcpy_P(pll, &pcm51xx_pll_table[i].pll, sizeof(*pll));
+      return true;
+    }
+  }
+
+  // Otherwise try every multiple of 16fs in the VCO range. Rank integer
+  // solutions first, then small P (fast phase detector), then multiples
+  // with more factors of two since they divide down most cleanly.
+  uint16_t best_score = 0;
+  for (uint32_t k = PCM51XX_PLL_MAX_HZ / osr_hz;
+       k * osr_hz >= PCM51XX_PLL_MIN_HZ; k--) {
+    pcm51xx_pll_t candidate;
+    if (!findPLLDividers(ref_hz, k * osr_hz, &candidate)) {
+      continue;
+    }
+
+    uint8_t twos = 0;
+    while (!((k >> twos) & 1) && twos < 15) {
+      twos++;
+    }
+    uint16_t score = ((candidate.d == 0) << 8) | ((16 - candidate.p) << 4) |
+                     twos;
+    if (score > best_score) {
+      best_score = score;
+      *pll = candidate;
+    }
+  }
+
+  return best_score != 0;
+}
+
+/*!
+ * @brief Lock the PLL to a reference clock and derive the DAC clocks from it
+ *
+ * Shorthand for planClocks() with the PLL as DAC clock source followed by
+ * applyClockPlan().
+ *
+ * @param ref PLL reference clock source
+ * @param ref_hz Reference clock frequency in Hz
+ * @param sample_rate Target sample rate in Hz
+ * @return True if successful, false if no valid setting exists or on error
+ */
+bool Adafruit_PCM51xx::configurePLL(pcm51xx_pll_ref_t ref, uint32_t ref_hz,
+                                    uint32_t sample_rate) {
+  pcm51xx_clock_plan_t plan;
+  return planClocks(PCM51XX_DAC_CLK_PLL, ref, ref_hz, sample_rate,
+                    PCM51XX_I2S_SIZE_32BIT, &plan) &&
+         applyClockPlan(&plan);
+}
+
+/*!
+ * @brief Compute the complete clock tree for a sample rate
+ *
+ * Derives the DSP, DAC, NCP and OSR dividers, speed mode and IDAC from the
+ * clock feeding the dividers: the PLL output when the DAC runs from the
+ * PLL (the PLL dividers are planned as well), the SCK or BCK frequency
+ * otherwise. The DSP clock is kept at or below 50MHz, the DAC clock at or
+ * below 6.144MHz, the charge pump near 1.536MHz and the OSR clock at
+ * exactly 16fs. The result is checked with validateClockPlan().
+ *
+ * The master clock auto-select source cannot be planned since the chip
+ * picks the clock itself.
+ *
+ * @param source DAC clock source (PLL, SCK or BCK)
+ * @param pll_ref PLL reference clock source, ignored unless source is PLL
+ * @param ref_hz SCK, BCK or PLL reference frequency in Hz. 0 for a BCK
+ *        reference derives it from the word size (32fs for 16-bit words,
+ *        64fs otherwise)
+ * @param sample_rate Target sample rate in Hz
+ * @param size I2S word size
+ * @param plan Pointer to store the clock plan
+ * @return True if a valid plan was found, false otherwise
+ */
+bool Adafruit_PCM51xx::planClocks(pcm51xx_dac_clk_src_t source,
+                                  pcm51xx_pll_ref_t pll_ref, uint32_t ref_hz,
+                                  uint32_t sample_rate,
+                                  pcm51xx_i2s_size_t size,
+                                  pcm51xx_clock_plan_t* plan) {
+  if (sample_rate == 0 || source == PCM51XX_DAC_CLK_MASTER) {
+    return false;
+  }
+
+  if (ref_hz == 0 && clockFromBCK(source, pll_ref)) {
+    ref_hz = (size == PCM51XX_I2S_SIZE_16BIT ? 32 : 64) * sample_rate;
+  }
+
+  memset(plan, 0, sizeof(*plan));
+  plan->source = source;
+  plan->pll_ref = pll_ref;
+  plan->ref_hz = ref_hz;
+  plan->sample_rate = sample_rate;
+  plan->master_hz = ref_hz;
+
+  if (source == PCM51XX_DAC_CLK_PLL) {
+    if (!planPLL(ref_hz, sample_rate, &plan->pll)) {
+      return false;
+    }
+    plan->master_hz = pllOutputHz(ref_hz, &plan->pll);
+  }
+
+  const uint32_t osr_hz = 16 * sample_rate;
+  const uint32_t master_hz = plan->master_hz;
+  if (master_hz % osr_hz) {
+    return false;
+  }
+  uint32_t ratio = master_hz / osr_hz;
+
+  // Smallest DAC divider that keeps the DAC clock in range and splits the
+  // master/16fs ratio evenly with the OSR divider
+  uint32_t dac_div = (master_hz + PCM51XX_DAC_MAX_HZ - 1) / PCM51XX_DAC_MAX_HZ;
+  while (dac_div <= ratio && ratio % dac_div) {
+    dac_div++;
+  }
+  if (dac_div > ratio) {
+    return false;
+  }
+  uint32_t osr_div = ratio / dac_div;
+  uint32_t ncp_div =
+      (master_hz / dac_div + PCM51XX_NCP_HZ / 2) / PCM51XX_NCP_HZ;
+  uint32_t dsp_div = (master_hz + PCM51XX_DSP_MAX_HZ - 1) / PCM51XX_DSP_MAX_HZ;
+  uint32_t idac = (master_hz / dsp_div) / sample_rate;
+  if (dac_div > 128 || osr_div > 128 || ncp_div > 128 || dsp_div > 128 ||
+      idac > 0xFFFF) {
+    return false;
+  }
+
+  plan->dsp_div = dsp_div;
+  plan->dac_div = dac_div;
+  plan->osr_div = osr_div;
+  plan->ncp_div = ncp_div ? ncp_div : 1;
+  plan->idac = idac;
+
+  if (sample_rate > 192000UL) {
+    plan->fs_speed = 3;
+  } else if (sample_rate > 96000UL) {
+    plan->fs_speed = 2;
+  } else if (sample_rate > 48000UL) {
+    plan->fs_speed = 1;
+  }
+
+  return validateClockPlan(plan);
+}
+
+/*!
+ * @brief Check a clock plan against the chip's clock limits
+ * @param plan Clock plan to check
+ * @return True if every divider is in range, the DSP and DAC clocks are
+ *         within their limits and the OSR clock comes out at exactly 16fs
+ */
+bool Adafruit_PCM51xx::validateClockPlan(const pcm51xx_clock_plan_t* plan) {
+  if (plan->sample_rate == 0 || plan->source == PCM51XX_DAC_CLK_MASTER) {
+    return false;
+  }
+
+  if (plan->source == PCM51XX_DAC_CLK_PLL) {
+    const pcm51xx_pll_t* pll = &plan->pll;
+    if (pll->p < 1 || pll->p > 15 || pll->j < 1 || pll->j > 63 ||
+        pll->d > 9999 || pll->r < 1 || pll->r > 16) {
+      return false;
+    }
+    uint32_t pd_hz = plan->ref_hz / pll->p;
+    if (pd_hz < 1000000UL || pd_hz > 20000000UL ||
+        plan->master_hz != pllOutputHz(plan->ref_hz, pll) ||
+        plan->master_hz < PCM51XX_PLL_MIN_HZ ||
+        plan->master_hz > PCM51XX_PLL_MAX_HZ) {
+      return false;
+    }
+  } else if (plan->master_hz != plan->ref_hz) {
+    return false;
+  }
+
+  if (plan->dsp_div < 1 || plan->dsp_div > 128 || plan->dac_div < 1 ||
+      plan->dac_div > 128 || plan->ncp_div < 1 || plan->ncp_div > 128 ||
+      plan->osr_div < 1 || plan->osr_div > 128 || plan->fs_speed > 3) {
+    return false;
+  }
+
+  return plan->master_hz / plan->dsp_div <= PCM51XX_DSP_MAX_HZ &&
+         plan->master_hz / plan->dac_div <= PCM51XX_DAC_MAX_HZ &&
+         (uint32_t)plan->dac_div * plan->osr_div * 16 * plan->sample_rate ==
+             plan->master_hz &&
+         plan->idac != 0;
+}
+
+/*!
+ * @brief Program a complete clock tree
+ *
+ * Disables clock autoset, so the chip no longer waits to detect the
+ * incoming clocks, and writes the clock source, PLL and every divider in
+ * one batched transaction. The chip is held in standby while the clocks
+ * change and released afterwards.
+ *
+ * @param plan Clock plan from planClocks()
+ * @return True if successful, false if the plan is invalid or on error
+ */
+bool Adafruit_PCM51xx::applyClockPlan(const pcm51xx_clock_plan_t* plan) {
+  PCM51XX_TIME_API(PCM51XX_API_CLOCK_PLAN);
+  if (!validateClockPlan(plan)) {
+    return false;
+  }
+
+  if (!standby(true)) {
+    return false;
+  }
+
+  Adafruit_PCM51xx_Transaction txn;
+  bool ok = queueClockPlan(plan, &txn) && commit(&txn);
+
+  ok = standby(false) && ok;
+  // On failure the chip holds neither plan, keep the old one but not valid
+  if (ok) {
+    _clock_plan = *plan;
+  }
+  _clock_plan_valid = ok;
+  return ok;
+}
+
+/*!
+ * @brief Get the clock tree last programmed with applyClockPlan() or
+ *        switchSampleRate()
+ * @param plan Pointer to store the clock plan
+ * @return True if a plan is in effect, false if none was applied since the
+ *         last reset
+ */
+bool Adafruit_PCM51xx::getClockPlan(pcm51xx_clock_plan_t* plan) {
+  if (!_clock_plan_valid) {
+    return false;
+  }
+  *plan = _clock_plan;
+  return true;
+}
+
+/*!
+ * @brief Switch to another sample rate on the current clock source
+ *
+ * Replans the clock tree for the new rate on the source and reference of
+ * the current plan. A BCK reference is assumed to keep its bits per frame,
+ * so it scales with the sample rate. Use the plan overload with plans made
+ * ahead of time to keep the planning off the switch path.
+ *
+ * @param sample_rate New sample rate in Hz
+ * @return True if successful, false if no plan is in effect, the new rate
+ *         cannot be reached or on error
+ */
+bool Adafruit_PCM51xx::switchSampleRate(uint32_t sample_rate) {
+  if (!_clock_plan_valid) {
+    return false;
+  }
+
+  uint32_t ref_hz = _clock_plan.ref_hz;
+  if (clockFromBCK(_clock_plan.source, _clock_plan.pll_ref)) {
+    if (ref_hz % _clock_plan.sample_rate) {
+      return false;
+    }
+    ref_hz = ref_hz / _clock_plan.sample_rate * sample_rate;
+  }
+
+  pcm51xx_clock_plan_t plan;
+  return planClocks(_clock_plan.source, _clock_plan.pll_ref, ref_hz,
+                    sample_rate, PCM51XX_I2S_SIZE_32BIT, &plan) &&
+         switchSampleRate(&plan);
+}
+
+/*!
+ * @brief Switch to a precomputed clock plan, writing only what changed
+ *
+ * Compared to applyClockPlan(), only the PLL, divider, speed mode and IDAC
+ * registers that differ from the current plan are written. When the PLL
+ * settings stay the same the DAC is only halted through the sync request
+ * and resynchronised afterwards; standby is used only when the PLL has to
+ * relock. Falls back to applyClockPlan() if no plan is in effect or the
+ * clock source changes.
+ *
+ * @param plan Clock plan from planClocks()
+ * @return True if successful, false if the plan is invalid or on error
+ */
+bool Adafruit_PCM51xx::switchSampleRate(const pcm51xx_clock_plan_t* plan) {
+  PCM51XX_TIME_API(PCM51XX_API_SWITCH_RATE);
+  if (!validateClockPlan(plan)) {
+    return false;
+  }
+
+  uint32_t start = micros();
+  if (!_clock_plan_valid || plan->source != _clock_plan.source ||
+      plan->pll_ref != _clock_plan.pll_ref) {
+    bool ok = applyClockPlan(plan);
+    _switch_time = micros() - start;
+    return ok;
+  }
+
+  const uint8_t len = PCM51XX_REG_IDAC_LSB - PCM51XX_REG_PLL_P + 1;
+  uint8_t old_regs[len];
+  uint8_t new_regs[len];
+  encodeClockPlan(&_clock_plan, old_regs);
+  encodeClockPlan(plan, new_regs);
+
+  // Each contiguous register group goes out as one burst covering the
+  // first to the last changed register
+  static const uint8_t groups[3][2] = {
+      {PCM51XX_REG_PLL_P, PCM51XX_REG_PLL_R},
+      {PCM51XX_REG_DSP_CLK_DIV, PCM51XX_REG_OSR_CLK_DIV},
+      {PCM51XX_REG_FS_SPEED, PCM51XX_REG_IDAC_LSB}};
+  bool pll_changed =
+      memcmp(&old_regs[0], &new_regs[0],
+             PCM51XX_REG_PLL_R - PCM51XX_REG_PLL_P + 1) != 0;
+
+  bool ok =
+      pll_changed ? standby(true) : writeField<PCM51XX_FIELD_SYNC_REQ>(1);
+  if (!ok) {
+    return false;
+  }
+
+  Adafruit_PCM51xx_Transaction txn;
+  beginTransaction(&txn);
+  for (uint8_t g = 0; g < 3 && ok; g++) {
+    int16_t first = -1;
+    int16_t last = -1;
+    for (uint8_t reg = groups[g][0]; reg <= groups[g][1]; reg++) {
+      uint8_t i = reg - PCM51XX_REG_PLL_P;
+      if (old_regs[i] != new_regs[i]) {
+        if (first < 0) {
+          first = i;
+        }
+        last = i;
+      }
+    }
+    if (first >= 0) {
+      ok = writeRegisters(0, PCM51XX_REG_PLL_P + first, &new_regs[first],
+                          last - first + 1);
+    }
+  }
+  ok = endTransaction() && ok;
+
+  ok = (pll_changed ? standby(false)
+                    : writeField<PCM51XX_FIELD_SYNC_REQ>(0)) &&
+       ok;
+  _switch_time = micros() - start;
+
+  // On failure the chip holds neither plan, keep the old one but not valid
+  if (ok) {
+    _clock_plan = *plan;
+  }
+  _clock_plan_valid = ok;
+  return ok;
+}
+
+/*!
+ * @brief Get how long the last switchSampleRate() held the DAC
+ * @return Switch duration in microseconds
+ */
+uint32_t Adafruit_PCM51xx::getSwitchTime(void) {
+  return _switch_time;
+}
+
+/*!
+ * @brief Decode the clock detection registers
+ * @param values Contents of registers 0x5B-0x5F
+ * @param detect Pointer to store the decoded detection results
+ */
+static void decodeClockDetect(const uint8_t* values,
+                              pcm51xx_clock_detect_t* detect) {
+  static const uint16_t sck_ratios[16] = {0,    32,   48,   64,  128,  192,
+                                          256,  384,  512,  768, 1024, 1152,
+                                          1536, 2048, 3072, 0};
+
+  uint8_t fs = (values[0] >> 4) & 0x07;
+  detect->fs = fs > PCM51XX_FS_384K ? PCM51XX_FS_ERROR
+                                    : (pcm51xx_fs_detect_t)fs;
+  detect->sck_ratio = sck_ratios[values[0] & 0x0F];
+  detect->bck_ratio = ((uint16_t)(values[1] & 0x01) << 8) | values[2];
+  detect->errors = values[3] & 0x7F;
+  detect->clock_halt = values[4] & 0x10;
+}
+
+/*!
+ * @brief Read the clock detection results and error flags
+ *
+ * All five detection registers (0x5B-0x5F) come in with a single burst
+ * read, so this is cheap enough to poll.
+ *
+ * @param detect Pointer to store the decoded detection results
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::getClockDetect(pcm51xx_clock_detect_t* detect) {
+  uint8_t values[5];
+  if (!readRegisters(0, PCM51XX_REG_RATE_DETECT_1, values, 5)) {
+    return false;
+  }
+
+  decodeClockDetect(values, detect);
+  return true;
+}
+
+/*!
+ * @brief Read a snapshot of all status registers
+ *
+ * Covers everything isPLLLocked(), isMuted(), getPowerState(),
+ * getDSPBootDone(), getClockDetect() and the GPIO and mute monitors
+ * report, in four burst reads: mute and PLL (0x03-0x04), DSP overflow and
+ * clock detection (0x5A-0x5F), analog mute (0x6C) and power state, GPIO
+ * input and auto mute (0x76-0x78).
+ *
+ * @param status Pointer to store the snapshot
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::getStatus(pcm51xx_status_t* status) {
+  PCM51XX_TIME_API(PCM51XX_API_STATUS);
+  uint8_t mute_pll[2];
+  uint8_t clocks[6];
+  uint8_t power[3];
+  if (!readRegisters(0, PCM51XX_REG_MUTE, mute_pll, 2) ||
+      !readRegisters(0, PCM51XX_REG_DSP_OVERFLOW, clocks, 6) ||
+      !readRegisters(0, PCM51XX_REG_ANALOG_MUTE, &status->analog_mute, 1) ||
+      !readRegisters(0, PCM51XX_REG_POWER_STATE, power, 3)) {
+    return false;
+  }
+
+  status->muted = PCM51XX_FIELD_MUTE_LEFT::get(mute_pll[0]) &&
+                  PCM51XX_FIELD_MUTE_RIGHT::get(mute_pll[0]);
+  status->pll_locked = !PCM51XX_FIELD_PLL_LOCK::get(mute_pll[1]);
+  status->dsp_overflow = clocks[0];
+  decodeClockDetect(&clocks[1], &status->clock);
+  status->power_state =
+      (pcm51xx_power_state_t)PCM51XX_FIELD_POWER_STATE::get(power[0]);
+  status->dsp_boot_done = PCM51XX_FIELD_DSP_BOOT_DONE::get(power[0]);
+  status->gpio_input = PCM51XX_FIELD_GPIO_INPUT::get(power[1]);
+  status->auto_mute = power[2];
+  return true;
+}
+
+/*!
+ * @brief Select the DSP program
+ * @param program Program number (1-31, PCM51XX_DSP_PROGRAM_RAM runs the
+ *        program loaded into instruction RAM)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setDSPProgram(uint8_t program) {
+  if (program < 1 || program > 31) {
+    return false;
+  }
+  return writeField<PCM51XX_FIELD_DSP_PROGRAM>(program);
+}
+
+/*!
+ * @brief Get the selected DSP program
+ * @return Program number, 0 on error
+ */
+uint8_t Adafruit_PCM51xx::getDSPProgram(void) {
+  uint8_t value;
+  if (!readField<PCM51XX_FIELD_DSP_PROGRAM>(&value)) {
+    return 0;
+  }
+
+  return value;
+}
+
+/*!
+ * @brief Update a CRC-16/CCITT with a block of data
+ * @param crc Running CRC (start with 0xFFFF)
+ * @param data Data bytes
+ * @param len Number of bytes
+ * @return Updated CRC
+ */
+static uint16_t crc16(uint16_t crc, const uint8_t* data, uint8_t len) {
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+/*!
+ * @brief Write or verify a run of registers within one page
+ *
+ * Writes go out as one burst straight from RAM data, or in
+ * PCM51XX_DSP_CHUNK pieces from PROGMEM. Verification reads the run back
+ * instead. Only DSP memory bytes (coefficient and instruction RAM pages,
+ * from PCM51XX_DSP_FIRST_REG on) count towards the CRCs and are verified;
+ * control registers are skipped when verifying.
+ *
+ * @param page Register page
+ * @param reg First register address
+ * @param data Data bytes
+ * @param len Number of bytes, must not run past register 0x7F
+ * @param progmem True if data is in PROGMEM
+ * @param verify True to read back and compare instead of writing
+ * @param crc Running CRC of the data
+ * @param check Running CRC of the readback (verification only)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::dspSegment(uint8_t page, uint8_t reg,
+                                  const uint8_t* data, uint8_t len,
+                                  bool progmem, bool verify, uint16_t* crc,
+                                  uint16_t* check) {
+  bool dsp_memory =
+      page >= PCM51XX_PAGE_CRAM_A && reg >= PCM51XX_DSP_FIRST_REG;
+  if (verify && !dsp_memory) {
+    return true;
+  }
+
+  if (!verify && !progmem) {
+    if (dsp_memory) {
+      *crc = crc16(*crc, data, len);
+      _dsp_load.bytes += len;
+    }
+    return writeRegisters(page, reg, data, len);
+  }
+
+  uint8_t buffer[PCM51XX_DSP_CHUNK];
+  for (uint8_t offset = 0; offset < len;) {
+    uint8_t n = min(len - offset, PCM51XX_DSP_CHUNK);
+    const uint8_t* src = data + offset;
+    if (progmem) {
+      memcpy_P(buffer, src, n);
+      src = buffer;
+    }
+    if (dsp_memory) {
+      *crc = crc16(*crc, src, n);
+      _dsp_load.bytes += n;
+    }
+
+    if (verify) {
+      if (!readRegisters(page, reg + offset, buffer, n)) {
+        return false;
+      }
+      *check = crc16(*check, buffer, n);
+    } else if (!writeRegisters(page, reg + offset, src, n)) {
+      return false;
+    }
+    offset += n;
+  }
+  return true;
+}
+
+/*!
+ * @brief Write or verify a DSP memory block that may span several pages
+ *
+ * DSP memory uses registers PCM51XX_DSP_FIRST_REG-0x7F of each page, so
+ * the block continues at PCM51XX_DSP_FIRST_REG of the next page.
+ *
+ * @param page First page
+ * @param reg First register address (PCM51XX_DSP_FIRST_REG-0x7F)
+ * @param data Data bytes
+ * @param len Number of bytes
+ * @param progmem True if data is in PROGMEM
+ * @param verify True to read back and compare instead of writing
+ * @param crc Running CRC of the data
+ * @param check Running CRC of the readback (verification only)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::transferDSPMemory(uint8_t page, uint8_t reg,
+                                         const uint8_t* data, uint16_t len,
+                                         bool progmem, bool verify,
+                                         uint16_t* crc, uint16_t* check) {
+  if (page < PCM51XX_PAGE_CRAM_A || reg < PCM51XX_DSP_FIRST_REG ||
+      reg > 0x7F) {
+    return false;
+  }
+
+  while (len) {
+    uint8_t n = min(len, (uint16_t)(0x80 - reg));
+    if (!dspSegment(page, reg, data, n, progmem, verify, crc, check)) {
+      return false;
+    }
+    data += n;
+    len -= n;
+    reg += n;
+    if (reg > 0x7F) {
+      page++;
+      reg = PCM51XX_DSP_FIRST_REG;
+    }
+  }
+  return true;
+}
+
+/*!
+ * @brief Write a block of coefficient or instruction RAM
+ *
+ * The block is sent in the longest bursts the bus allows and continues
+ * across page boundaries. Size, duration and CRC are available from
+ * getDSPLoadInfo() afterwards.
+ *
+ * @param page First page (PCM51XX_PAGE_CRAM_A and up)
+ * @param reg First register address (PCM51XX_DSP_FIRST_REG-0x7F)
+ * @param data Data bytes, 4 per coefficient or instruction word
+ * @param len Number of bytes
+ * @param progmem True if data is in PROGMEM
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::writeDSPMemory(uint8_t page, uint8_t reg,
+                                      const uint8_t* data, uint16_t len,
+                                      bool progmem) {
+  PCM51XX_TIME_API(PCM51XX_API_DSP_LOAD);
+  uint32_t start = micros();
+  uint16_t crc = 0xFFFF;
+  _dsp_load.bytes = 0;
+  _dsp_load.verified = false;
+
+  bool ok = transferDSPMemory(page, reg, data, len, progmem, false, &crc,
+                              nullptr);
+  _dsp_load.crc = crc;
+  _dsp_load.time = micros() - start;
+  return ok;
+}
+
+/*!
+ * @brief Check a block of coefficient or instruction RAM by readback CRC
+ * @param page First page (PCM51XX_PAGE_CRAM_A and up)
+ * @param reg First register address (PCM51XX_DSP_FIRST_REG-0x7F)
+ * @param data Expected data bytes
+ * @param len Number of bytes
+ * @param progmem True if data is in PROGMEM
+ * @return True if the readback CRC matches the expected data
+ */
+bool Adafruit_PCM51xx::verifyDSPMemory(uint8_t page, uint8_t reg,
+                                       const uint8_t* data, uint16_t len,
+                                       bool progmem) {
+  uint32_t start = micros();
+  uint16_t crc = 0xFFFF;
+  uint16_t check = 0xFFFF;
+  _dsp_load.bytes = 0;
+
+  bool ok =
+      transferDSPMemory(page, reg, data, len, progmem, true, &crc, &check);
+  _dsp_load.crc = crc;
+  _dsp_load.verified = ok && crc == check;
+  _dsp_load.time = micros() - start;
+  return _dsp_load.verified;
+}
+
+/*!
+ * @brief Write or verify every register write in a script
+ * @param script Script bytes, see loadDSPScript()
+ * @param len Script length in bytes
+ * @param progmem True if the script is in PROGMEM
+ * @param verify True to read back and compare instead of writing
+ * @param crc Running CRC of the DSP memory data
+ * @param check Running CRC of the readback (verification only)
+ * @return True if successful, false on a malformed script or bus error
+ */
+bool Adafruit_PCM51xx::runDSPScript(const uint8_t* script, uint16_t len,
+                                    bool progmem, bool verify, uint16_t* crc,
+                                    uint16_t* check) {
+  uint8_t run[PCM51XX_DSP_CHUNK];
+  uint8_t run_page = 0;
+  uint8_t run_reg = 0;
+  uint8_t run_len = 0;
+  uint8_t page = 0;
+
+  for (uint16_t i = 0; i + 1 < len; i += 2) {
+    uint8_t cmd[2];
+    if (progmem) {
+      memcpy_P(cmd, script + i, 2);
+    } else {
+      memcpy(cmd, script + i, 2);
+    }
+
+    // Consecutive single writes to neighbouring registers are merged into
+    // one burst
+    bool plain = cmd[0] != PCM51XX_REG_PAGE_SELECT &&
+                 cmd[0] < PCM51XX_SCRIPT_BURST;
+    if (run_len && (!plain || page != run_page ||
+                    cmd[0] != run_reg + run_len ||
+                    run_len == PCM51XX_DSP_CHUNK)) {
+      if (!dspSegment(run_page, run_reg, run, run_len, false, verify, crc,
+                      check)) {
+        return false;
+      }
+      run_len = 0;
+    }
+
+    if (plain) {
+      if (!run_len) {
+        run_page = page;
+        run_reg = cmd[0];
+      }
+      run[run_len++] = cmd[1];
+    } else if (cmd[0] == PCM51XX_REG_PAGE_SELECT) {
+      page = cmd[1];
+    } else if (cmd[0] == PCM51XX_SCRIPT_DELAY) {
+      if (!verify) {
+        delay(cmd[1]);
+      }
+    } else if (cmd[0] == PCM51XX_SCRIPT_BURST) {
+      // Register address and data follow, padded to a whole command
+      uint8_t n = cmd[1];
+      const uint8_t* burst = script + i + 2;
+      if (n < 2 || i + 2 + n > len) {
+        return false;
+      }
+      uint8_t reg = progmem ? pgm_read_byte(burst) : burst[0];
+      if (reg + n - 1 > 0x80 ||
+          !dspSegment(page, reg, burst + 1, n - 1, progmem, verify, crc,
+                      check)) {
+        return false;
+      }
+      i += (n + 1) & ~1;
+    }
+  }
+
+  return !run_len ||
+         dspSegment(run_page, run_reg, run, run_len, false, verify, crc,
+                    check);
+}
+
+/*!
+ * @brief Load a register script such as a PPC3 configuration export
+ *
+ * The script is a list of (register, value) byte pairs. Register 0x00
+ * selects the page for the following writes. Three meta commands are
+ * understood: {PCM51XX_SCRIPT_DELAY, ms} waits, {PCM51XX_SCRIPT_BURST, n}
+ * is followed by a register address and n - 1 data bytes (padded to an
+ * even length), and PCM51XX_SCRIPT_SWITCH is ignored. Runs of writes to
+ * consecutive registers are merged into bursts.
+ *
+ * @param script Script bytes
+ * @param len Script length in bytes
+ * @param progmem True if the script is in PROGMEM
+ * @param verify True to read back the DSP memory written by the script
+ *        and compare CRCs afterwards
+ * @return True if successful (and verified, if requested), false otherwise
+ */
+bool Adafruit_PCM51xx::loadDSPScript(const uint8_t* script, uint16_t len,
+                                     bool progmem, bool verify) {
+  PCM51XX_TIME_API(PCM51XX_API_DSP_LOAD);
+  uint32_t start = micros();
+  uint16_t crc = 0xFFFF;
+  uint16_t check = 0xFFFF;
+  _dsp_load.bytes = 0;
+  _dsp_load.verified = false;
+
+  bool ok = runDSPScript(script, len, progmem, false, &crc, nullptr);
+  _dsp_load.crc = crc;
+  if (ok && verify) {
+    uint32_t bytes = _dsp_load.bytes;
+    crc = 0xFFFF;
+    ok = runDSPScript(script, len, progmem, true, &crc, &check) &&
+         crc == check;
+    _dsp_load.bytes = bytes;
+    _dsp_load.verified = ok;
+  }
+  _dsp_load.time = micros() - start;
+  return ok;
+}
+
+/*!
+ * @brief Enable or disable adaptive (double-buffered) coefficient mode
+ *
+ * In adaptive mode the DSP runs from one coefficient buffer while the
+ * other one is written, and updateCoefficients() swaps them so filters
+ * change without glitches.
+ *
+ * @param enable True to enable adaptive mode, false to disable
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setAdaptiveMode(bool enable) {
+  return writeField<PCM51XX_FIELD_CRAM_ADAPTIVE>(enable ? 1 : 0);
+}
+
+/*!
+ * @brief Update coefficients without glitches
+ *
+ * With adaptive mode on, the data goes to the inactive buffer, the buffers
+ * are swapped at the next sample boundary and the data is then copied to
+ * the new inactive buffer, so both stay identical for the next update.
+ * getDSPLoadInfo() then describes the whole update: the bytes of both
+ * copies, the time including the swap and the CRC of data. Without
+ * adaptive mode the active buffer is written directly.
+ *
+ * @param offset Byte offset into the coefficient RAM (multiple of 4)
+ * @param data Coefficient bytes
+ * @param len Number of bytes
+ * @param progmem True if data is in PROGMEM
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::updateCoefficients(uint16_t offset, const uint8_t* data,
+                                          uint16_t len, bool progmem) {
+  PCM51XX_TIME_API(PCM51XX_API_COEFFICIENTS);
+  const uint8_t per_page = 0x80 - PCM51XX_DSP_FIRST_REG;
+  if (offset + len > PCM51XX_CRAM_PAGES * per_page) {
+    return false;
+  }
+
+  uint8_t ctrl;
+  if (!readRegister(PCM51XX_PAGE_CRAM_A, PCM51XX_REG_CRAM_CTRL, &ctrl)) {
+    return false;
+  }
+  uint8_t page = offset / per_page;
+  uint8_t reg = PCM51XX_DSP_FIRST_REG + offset % per_page;
+
+  if (!PCM51XX_FIELD_CRAM_ADAPTIVE::get(ctrl)) {
+    return writeDSPMemory(PCM51XX_PAGE_CRAM_A + page, reg, data, len,
+                          progmem);
+  }
+
+  bool b_active = PCM51XX_FIELD_CRAM_ACTIVE_B::get(ctrl);
+  uint8_t inactive = b_active ? PCM51XX_PAGE_CRAM_A : PCM51XX_PAGE_CRAM_B;
+  uint8_t active = b_active ? PCM51XX_PAGE_CRAM_B : PCM51XX_PAGE_CRAM_A;
+  uint32_t start = micros();
+  uint16_t crc = 0xFFFF;
+  uint16_t copy_crc = 0xFFFF;
+  _dsp_load.bytes = 0;
+  _dsp_load.verified = false;
+
+  bool ok = transferDSPMemory(inactive + page, reg, data, len, progmem, false,
+                              &crc, nullptr) &&
+            writeField<PCM51XX_FIELD_CRAM_SWAP>(1) &&
+            waitForClear(PCM51XX_PAGE_CRAM_A, PCM51XX_REG_CRAM_CTRL,
+                         PCM51XX_FIELD_CRAM_SWAP::mask()) &&
+            transferDSPMemory(active + page, reg, data, len, progmem, false,
+                              &copy_crc, nullptr);
+  _dsp_load.crc = crc;
+  _dsp_load.time = micros() - start;
+  return ok;
+}
+
+/*!
+ * @brief Read coefficients from the buffer the DSP is running from
+ * @param offset Byte offset into the coefficient RAM (multiple of 4)
+ * @param data Buffer for the coefficient bytes
+ * @param len Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::readCoefficients(uint16_t offset, uint8_t* data,
+                                        uint16_t len) {
+  const uint8_t per_page = 0x80 - PCM51XX_DSP_FIRST_REG;
+  if (offset + len > PCM51XX_CRAM_PAGES * per_page) {
+    return false;
+  }
+
+  // In adaptive mode buffer B may be the active one
+  uint8_t ctrl;
+  if (!readRegister(PCM51XX_PAGE_CRAM_A, PCM51XX_REG_CRAM_CTRL, &ctrl)) {
+    return false;
+  }
+  uint8_t base = PCM51XX_FIELD_CRAM_ADAPTIVE::get(ctrl) &&
+                         PCM51XX_FIELD_CRAM_ACTIVE_B::get(ctrl)
+                     ? PCM51XX_PAGE_CRAM_B
+                     : PCM51XX_PAGE_CRAM_A;
+
+  while (len) {
+    uint8_t page = base + offset / per_page;
+    uint8_t reg = PCM51XX_DSP_FIRST_REG + offset % per_page;
+    uint8_t n = min(len, (uint16_t)(0x80 - reg));
+    if (!readRegisters(page, reg, data, n)) {
+      return false;
+    }
+    data += n;
+    offset += n;
+    len -= n;
+  }
+  return true;
+}
+
+/*!
+ * @brief Get the result of the last DSP memory load or verification
+ * @return Bytes transferred, duration, CRC and verification result
+ */
+pcm51xx_dsp_load_t Adafruit_PCM51xx::getDSPLoadInfo(void) {
+  return _dsp_load;
+}
+
+/*!
+ * @brief Design a biquad filter and quantise it for the DSP
+ *
+ * Uses the Audio EQ Cookbook (RBJ) formulas. Coefficients are normalised
+ * to a0 = 1, the feedback terms negated, and converted to 5.27 fixed
+ * point (range -16 to 16) as the DSP's biquads expect.
+ *
+ * @param type Filter type
+ * @param freq Center or corner frequency in Hz
+ * @param q Quality factor (0.707 for Butterworth low/high pass)
+ * @param gain_db Gain in dB (peaking and shelf filters only)
+ * @param sample_rate Sample rate in Hz
+ * @param biquad Pointer to store the coefficients
+ * @return True if successful, false if the parameters or the resulting
+ *         coefficients are out of range
+ */
+bool Adafruit_PCM51xx::designBiquad(pcm51xx_biquad_type_t type, float freq,
+                                    float q, float gain_db,
+                                    uint32_t sample_rate,
+                                    pcm51xx_biquad_t* biquad) {
+  if (sample_rate == 0 || freq <= 0 || freq >= sample_rate / 2.0 || q <= 0) {
+    return false;
+  }
+
+  float a = pow(10, gain_db / 40);
+  float w0 = 2 * PI * freq / sample_rate;
+  float cs = cos(w0);
+  float alpha = sin(w0) / (2 * q);
+  float sq = 2 * sqrt(a) * alpha;
+  float b[3];
+  float a0, a1, a2;
+
+  switch (type) {
+    case PCM51XX_BIQUAD_PEAKING:
+      b[0] = 1 + alpha * a;
+      b[1] = -2 * cs;
+      b[2] = 1 - alpha * a;
+      a0 = 1 + alpha / a;
+      a1 = -2 * cs;
+      a2 = 1 - alpha / a;
+      break;
+    case PCM51XX_BIQUAD_LOW_SHELF:
+      b[0] = a * ((a + 1) - (a - 1) * cs + sq);
+      b[1] = 2 * a * ((a - 1) - (a + 1) * cs);
+      b[2] = a * ((a + 1) - (a - 1) * cs - sq);
+      a0 = (a + 1) + (a - 1) * cs + sq;
+      a1 = -2 * ((a - 1) + (a + 1) * cs);
+      a2 = (a + 1) + (a - 1) * cs - sq;
+      break;
+    case PCM51XX_BIQUAD_HIGH_SHELF:
+      b[0] = a * ((a + 1) + (a - 1) * cs + sq);
+      b[1] = -2 * a * ((a - 1) + (a + 1) * cs);
+      b[2] = a * ((a + 1) + (a - 1) * cs - sq);
+      a0 = (a + 1) - (a - 1) * cs + sq;
+      a1 = 2 * ((a - 1) - (a + 1) * cs);
+      a2 = (a + 1) - (a - 1) * cs - sq;
+      break;
+    case PCM51XX_BIQUAD_LOW_PASS:
+      b[0] = (1 - cs) / 2;
+      b[1] = 1 - cs;
+      b[2] = (1 - cs) / 2;
+      a0 = 1 + alpha;
+      a1 = -2 * cs;
+      a2 = 1 - alpha;
+      break;
+    case PCM51XX_BIQUAD_HIGH_PASS:
+      b[0] = (1 + cs) / 2;
+      b[1] = -(1 + cs);
+      b[2] = (1 + cs) / 2;
+      a0 = 1 + alpha;
+      a1 = -2 * cs;
+      a2 = 1 - alpha;
+      break;
+    default:
+      return false;
+  }
+
+  float coefs[5] = {b[0] / a0, b[1] / a0, b[2] / a0, -a1 / a0, -a2 / a0};
+  int32_t fixed[5];
+  for (uint8_t i = 0; i < 5; i++) {
+    if (coefs[i] <= -16.0 || coefs[i] >= 16.0) {
+      return false;
+    }
+    fixed[i] = (int32_t)round(coefs[i] * 134217728.0);
+  }
+
+  biquad->b0 = fixed[0];
+  biquad->b1 = fixed[1];
+  biquad->b2 = fixed[2];
+  biquad->a1 = fixed[3];
+  biquad->a2 = fixed[4];
+  return true;
+}
+
+/*!
+ * @brief Write a biquad to coefficient RAM, changing only what differs
+ *
+ * The five coefficients are stored as b0, b1, b2, a1, a2, each a 4-byte
+ * word MSB first. The current coefficients are read back and only the
+ * span of words that changed is written, through updateCoefficients() so
+ * adaptive mode swaps buffers without glitches.
+ *
+ * @param offset Byte offset of the biquad in coefficient RAM, as laid out
+ *        by the loaded DSP program
+ * @param biquad Coefficients from designBiquad()
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::setBiquad(uint16_t offset,
+                                 const pcm51xx_biquad_t* biquad) {
+  const int32_t words[5] = {biquad->b0, biquad->b1, biquad->b2, biquad->a1,
+                            biquad->a2};
+  uint8_t data[20];
+  for (uint8_t i = 0; i < 5; i++) {
+    data[i * 4] = (words[i] >> 24) & 0xFF;
+    data[i * 4 + 1] = (words[i] >> 16) & 0xFF;
+    data[i * 4 + 2] = (words[i] >> 8) & 0xFF;
+    data[i * 4 + 3] = words[i] & 0xFF;
+  }
+
+  uint8_t current[20];
+  if (!readCoefficients(offset, current, 20)) {
+    return false;
+  }
+
+  int8_t first = -1;
+  int8_t last = -1;
+  for (uint8_t i = 0; i < 5; i++) {
+    if (memcmp(&data[i * 4], &current[i * 4], 4)) {
+      if (first < 0) {
+        first = i;
+      }
+      last = i;
+    }
+  }
+  if (first < 0) {
+    return true; // Nothing changed
+  }
+
+  return updateCoefficients(offset + first * 4, &data[first * 4],
+                            (last - first + 1) * 4);
+}
+
+/*!
+ * @brief Design a biquad for the current sample rate and write it
+ *
+ * The sample rate comes from the clock plan in effect, see
+ * applyClockPlan().
+ *
+ * @param offset Byte offset of the biquad in coefficient RAM
+ * @param type Filter type
+ * @param freq Center or corner frequency in Hz
+ * @param q Quality factor
+ * @param gain_db Gain in dB (peaking and shelf filters only)
+ * @return True if successful, false if no clock plan is in effect, the
+ *         design is out of range or on error
+ */
+bool Adafruit_PCM51xx::setBiquad(uint16_t offset, pcm51xx_biquad_type_t type,
+                                 float freq, float q, float gain_db) {
+  pcm51xx_biquad_t biquad;
+  return _clock_plan_valid &&
+         designBiquad(type, freq, q, gain_db, _clock_plan.sample_rate,
+                      &biquad) &&
+         setBiquad(offset, &biquad);
+}
+
+/*!
+ * @brief Registers stored in a configuration profile, in profile order
+ *
+ * The mask leaves out read-only status bits that share a register with
+ * settings.
+ */
+static const struct {
+  uint8_t page; ///< Register page
+  uint8_t reg;  ///< Register address
+  uint8_t mask; ///< Writable bits
+} pcm51xx_profile_regs[PCM51XX_PROFILE_SIZE] PROGMEM = {
+    {0, PCM51XX_REG_MUTE, 0xFF},
+    {0, PCM51XX_REG_PLL, 0x01},
+    {0, PCM51XX_REG_SPI_MISO, 0xFF},
+    {0, PCM51XX_REG_DEEMPHASIS, 0xFF},
+    {0, PCM51XX_REG_GPIO_ENABLE, 0xFF},
+    {0, PCM51XX_REG_BCK_LRCLK, 0xFF},
+    {0, PCM51XX_REG_DSP_GPIO, 0xFF},
+    {0, PCM51XX_REG_MASTER_MODE_RST, 0xFF},
+    {0, PCM51XX_REG_PLL_REF, 0xFF},
+    {0, PCM51XX_REG_DAC_CLK_SRC, 0xFF},
+    {0, PCM51XX_REG_GPIO_PLL_REF, 0xFF},
+    {0, PCM51XX_REG_PLL_P, 0xFF},
+    {0, PCM51XX_REG_PLL_J, 0xFF},
+    {0, PCM51XX_REG_PLL_D_MSB, 0xFF},
+    {0, PCM51XX_REG_PLL_D_LSB, 0xFF},
+    {0, PCM51XX_REG_PLL_R, 0xFF},
+    {0, PCM51XX_REG_DSP_CLK_DIV, 0xFF},
+    {0, PCM51XX_REG_DAC_CLK_DIV, 0xFF},
+    {0, PCM51XX_REG_NCP_CLK_DIV, 0xFF},
+    {0, PCM51XX_REG_OSR_CLK_DIV, 0xFF},
+    {0, PCM51XX_REG_MASTER_BCK_DIV, 0xFF},
+    {0, PCM51XX_REG_MASTER_LRCK_DIV, 0xFF},
+    {0, PCM51XX_REG_FS_SPEED, 0xFF},
+    {0, PCM51XX_REG_IDAC_MSB, 0xFF},
+    {0, PCM51XX_REG_IDAC_LSB, 0xFF},
+    {0, PCM51XX_REG_ERROR_DETECT, 0xFF},
+    {0, PCM51XX_REG_I2S_CONFIG, 0xFF},
+    {0, PCM51XX_REG_I2S_OFFSET, 0xFF},
+    {0, PCM51XX_REG_I2S_UPSAMPLE, 0xFF},
+    {0, PCM51XX_REG_DSP_PROGRAM, 0xFF},
+    {0, PCM51XX_REG_CLK_MISSING, 0xFF},
+    {0, PCM51XX_REG_AUTO_MUTE_TIME, 0xFF},
+    {0, PCM51XX_REG_DIGITAL_VOLUME_CTL, 0xFF},
+    {0, PCM51XX_REG_DIGITAL_VOLUME_L, 0xFF},
+    {0, PCM51XX_REG_DIGITAL_VOLUME_R, 0xFF},
+    {0, PCM51XX_REG_VOLUME_FADE, 0xFF},
+    {0, PCM51XX_REG_VOLUME_FADE_EMRG, 0xFF},
+    {0, PCM51XX_REG_AUTO_MUTE, 0xFF},
+    {0, PCM51XX_REG_GPIO1_OUTPUT, 0xFF},
+    {0, PCM51XX_REG_GPIO2_OUTPUT, 0xFF},
+    {0, PCM51XX_REG_GPIO3_OUTPUT, 0xFF},
+    {0, PCM51XX_REG_GPIO4_OUTPUT, 0xFF},
+    {0, PCM51XX_REG_GPIO5_OUTPUT, 0xFF},
+    {0, PCM51XX_REG_GPIO6_OUTPUT, 0xFF},
+    {0, PCM51XX_REG_GPIO_CONTROL, 0xFF},
+    {0, PCM51XX_REG_GPIO_INVERT, 0xFF},
+    {1, PCM51XX_REG_PAGE1_OUTPUT_AMP_TYPE, 0xFF},
+    {1, PCM51XX_REG_PAGE1_ANALOG_GAIN, 0xFF},
+    {1, PCM51XX_REG_PAGE1_UNDERVOLTAGE, 0xFF},
+    {1, PCM51XX_REG_PAGE1_ANALOG_MUTE, 0xFF},
+    {1, PCM51XX_REG_PAGE1_GAIN_BOOST, 0xFF},
+    {1, PCM51XX_REG_PAGE1_VCOM_RAMP, 0xFF},
+    {1, PCM51XX_REG_PAGE1_VCOM_POWER, 0xFF},
+};
+
+/*!
+ * @brief Read the current configuration into a profile
+ *
+ * Neighbouring profile registers are read together, so a capture takes a
+ * handful of burst reads.
+ *
+ * @param profile Pointer to store the profile
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::captureProfile(pcm51xx_profile_t* profile) {
+  uint8_t buffer[32];
+  uint8_t i = 0;
+
+  while (i < PCM51XX_PROFILE_SIZE) {
+    uint8_t first[3];
+    memcpy_P(first, &pcm51xx_profile_regs[i], 3);
+
+    // Extend the burst over every following register that fits
+    uint8_t end = i + 1;
+    uint8_t last_reg = first[1];
+    while (end < PCM51XX_PROFILE_SIZE) {
+      uint8_t next[3];
+      memcpy_P(next, &pcm51xx_profile_regs[end], 3);
+      if (next[0] != first[0] ||
+          (uint8_t)(next[1] - first[1]) >= sizeof(buffer)) {
+        break;
+      }
+      last_reg = next[1];
+      end++;
+    }
+
+    if (!readRegisters(first[0], first[1], buffer, last_reg - first[1] + 1)) {
+      return false;
+    }
+    for (; i < end; i++) {
+      uint8_t entry[3];
+      memcpy_P(entry, &pcm51xx_profile_regs[i], 3);
+      profile->values[i] = buffer[entry[1] - first[1]] & entry[2];
+    }
+  }
+  return true;
+}
+
+/*!
+ * @brief Apply a profile, writing only the registers that differ
+ *
+ * The current values come from the shadow cache when it holds all of them
+ * and from captureProfile() otherwise. The differing registers are written
+ * in one transaction, so neighbouring ones share bursts. If the profiles
+ * differ in the PLL or clock dividers, the chip is held in standby while
+ * they are written and released afterwards, as applyClockPlan() does.
+ *
+ * @param profile Profile to apply
+ * @param progmem True if the profile is in PROGMEM
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::applyProfile(const pcm51xx_profile_t* profile,
+                                    bool progmem) {
+  PCM51XX_TIME_API(PCM51XX_API_PROFILE);
+  pcm51xx_profile_t target;
+  if (progmem) {
+    memcpy_P(&target, profile, sizeof(target));
+  } else {
+    target = *profile;
+  }
+
+  pcm51xx_profile_t current;
+  bool cached = true;
+  for (uint8_t i = 0; i < PCM51XX_PROFILE_SIZE && cached; i++) {
+    uint8_t entry[3];
+    memcpy_P(entry, &pcm51xx_profile_regs[i], 3);
+    cached = peekCache(entry[0], entry[1], &current.values[i]);
+    if (cached) {
+      current.values[i] &= entry[2];
+    }
+  }
+  if (!cached && !captureProfile(&current)) {
+    return false;
+  }
+
+  pcm51xx_reg_write_t diffs[PCM51XX_PROFILE_SIZE];
+  uint8_t count = diffProfiles(&current, &target, diffs, PCM51XX_PROFILE_SIZE);
+  if (!count) {
+    return true;
+  }
+
+  // A different clock tree invalidates the clock plan and, as in
+  // applyClockPlan(), is only written while the chip is in standby
+  bool clocks = false;
+  for (uint8_t i = 0; i < count; i++) {
+    if (diffs[i].page == 0 &&
+        (diffs[i].reg == PCM51XX_REG_PLL ||
+         (diffs[i].reg >= PCM51XX_REG_PLL_REF &&
+          diffs[i].reg <= PCM51XX_REG_IDAC_LSB))) {
+      clocks = true;
+    }
+  }
+  if (clocks) {
+    if (!standby(true)) {
+      return false;
+    }
+    _clock_plan_valid = false;
+  }
+
+  Adafruit_PCM51xx_Transaction txn;
+  beginTransaction(&txn);
+  bool ok = true;
+  for (uint8_t i = 0; i < count && ok; i++) {
+    ok = updateRegister(diffs[i].page, diffs[i].reg, diffs[i].mask,
+                        diffs[i].value);
+  }
+  ok = endTransaction() && ok;
+
+  if (clocks) {
+    ok = standby(false) && ok;
+  }
+  return ok;
+}
+
+/*!
+ * @brief List the register writes that turn one profile into another
+ * @param from Starting profile
+ * @param to Target profile
+ * @param diffs Array to store the differing registers (masked writes of
+ *        the target values), may be nullptr to only count them
+ * @param max_diffs Size of the diffs array
+ * @return Number of differing registers, which may exceed max_diffs
+ */
+uint8_t Adafruit_PCM51xx::diffProfiles(const pcm51xx_profile_t* from,
+                                       const pcm51xx_profile_t* to,
+                                       pcm51xx_reg_write_t* diffs,
+                                       uint8_t max_diffs) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < PCM51XX_PROFILE_SIZE; i++) {
+    if (from->values[i] == to->values[i]) {
+      continue;
+    }
+    if (diffs && count < max_diffs) {
+      uint8_t entry[3];
+      memcpy_P(entry, &pcm51xx_profile_regs[i], 3);
+      diffs[count].page = entry[0];
+      diffs[count].reg = entry[1];
+      diffs[count].mask = entry[2];
+      diffs[count].value = to->values[i];
+    }
+    count++;
+  }
+  return count;
+}
+
+/*!
+ * @brief Select register page
+ * @param page Page number to select (0-255)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::selectPage(uint8_t page) {
+  if (_page == page) {
+#ifdef PCM51XX_INSTRUMENT
+    _instrument.pages_avoided++;
+#endif
+    return true; // Already on correct page, skip bus write
+  }
+
+  _bus_stats.page_selects++;
+  if (busWrite(PCM51XX_REG_PAGE_SELECT, &page, 1)) {
+    _page = page; // Update cached page on successful write
+    return true;
+  }
+  return false;
+}
+
+/*!
+ * @brief Get the bus traffic counters
+ *
+ * Every transfer the library makes goes through one place and is counted
+ * here, so the cost of any call can be measured by comparing the counters
+ * before and after it.
+ *
+ * @return Bus traffic since creation or the last resetBusStats()
+ */
+pcm51xx_bus_stats_t Adafruit_PCM51xx::getBusStats(void) {
+  return _bus_stats;
+}
+
+/*!
+ * @brief Clear the bus traffic counters
+ */
+void Adafruit_PCM51xx::resetBusStats(void) {
+  memset(&_bus_stats, 0, sizeof(_bus_stats));
+}
+
+/*!
+ * @brief Set how failed bus transfers are retried
+ *
+ * Each retry first waits, starting at backoff_us and doubling every time,
+ * then reselects the page the transfer was meant for. The default is no
+ * retries.
+ *
+ * @param retries Extra attempts per transfer (0 to fail at once)
+ * @param backoff_us Wait before the first retry in us
+ */
+void Adafruit_PCM51xx::setRetryPolicy(uint8_t retries, uint16_t backoff_us) {
+  _retries = retries;
+  _retry_backoff = backoff_us;
+}
+
+/*!
+ * @brief Check for a chip reset after bus errors
+ *
+ * When enabled, the first register access after a bus error runs
+ * checkReset() so a chip that browned out gets its configuration back.
+ *
+ * @param enable True to check after errors, false to leave it to the caller
+ */
+void Adafruit_PCM51xx::enableAutoRecover(bool enable) {
+  _auto_recover = enable;
+  _reset_check = false;
+}
+
+/*!
+ * @brief Run checkReset() if a bus error asked for it
+ */
+void Adafruit_PCM51xx::recoverIfNeeded(void) {
+  if (_reset_check && !_recovering) {
+    checkReset();
+  }
+}
+
+/*!
+ * @brief Track writes to the registers checkReset() relies on
+ *
+ * Runs whether or not the shadow cache is enabled, so the check always
+ * knows the last value written to the error detection register. A register
+ * reset, or a write to the reset register that may have landed, also drops
+ * the shadow cache and the clock plan, whichever path sent it.
+ *
+ * @param page Register page
+ * @param reg Register address
+ * @param value Value written
+ * @param ok True if the write is known to have landed
+ */
+void Adafruit_PCM51xx::noteWrite(uint8_t page, uint8_t reg, uint8_t value,
+                                 bool ok) {
+  if (page != 0) {
+    return;
+  }
+  if (reg == PCM51XX_REG_ERROR_DETECT) {
+    // After a failed write the value is unknown, which turns the check off
+    _error_detect = ok ? value : 0;
+  } else if (reg == PCM51XX_REG_RESET &&
+             (!ok || (value & PCM51XX_FIELD_RESET_REGISTERS::mask()))) {
+    _error_detect = 0;
+    invalidateCache();
+    _clock_plan_valid = false;
+  }
+}
+
+/*!
+ * @brief Check if the chip has reset and restore its configuration if so
+ *
+ * begin() never leaves the error detection register at its reset default
+ * of 0, so reading 0 there after a nonzero value was last written to it
+ * means the chip lost its configuration, which is then reapplied with
+ * restoreConfiguration(). If the register was cleared on purpose, or the
+ * last write to it failed, there is nothing to compare against and no
+ * reset is reported. Costs one register read.
+ *
+ * @return True if the chip kept its configuration or it was restored,
+ *         false if the check or the restore failed
+ */
+bool Adafruit_PCM51xx::checkReset(void) {
+  BusLock lock(this);
+  _reset_check = false;
+  _recovering = true;
+
+  uint8_t value = 0;
+  bool ok = selectPage(0) && busRead(PCM51XX_REG_ERROR_DETECT, &value, 1);
+  _recovering = false;
+
+  if (!ok || value != 0x00 || _error_detect == 0x00) {
+    return ok;
+  }
+
+  _error_stats.resets++;
+  _last_error = PCM51XX_ERROR_RESET;
+  return restoreConfiguration();
+}
+
+/*!
+ * @brief Reapply the configuration after the chip lost it
+ *
+ * Writes the begin() register image with every register held in the
+ * shadow cache on top of it, then the clock plan if one was applied.
+ * Enable the cache to have changes made after begin() restored. DSP
+ * memory contents are not restored.
+ *
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::restoreConfiguration(void) {
+  BusLock lock(this);
+  Adafruit_PCM51xx_Transaction* batch = _txn;
+  _recovering = true;
+  _page = 0xFF;
+
+  Adafruit_PCM51xx_Transaction txn;
+  beginTransaction(&txn);
+  bool ok = true;
+  const uint8_t image_len =
+      sizeof(pcm51xx_boot_image) / sizeof(pcm51xx_boot_image[0]);
+  for (uint8_t i = 0; i < image_len; i++) {
+    const pcm51xx_reg_write_t* w = &pcm51xx_boot_image[i];
+    uint8_t value = w->value;
+    peekCache(w->page, w->reg, &value);
+    ok = updateRegister(w->page, w->reg, w->mask, value) && ok;
+  }
+  for (uint8_t i = 0; i < PCM51XX_PROFILE_SIZE; i++) {
+    uint8_t entry[3];
+    uint8_t value;
+    memcpy_P(entry, &pcm51xx_profile_regs[i], 3);
+    if (peekCache(entry[0], entry[1], &value)) {
+      ok = updateRegister(entry[0], entry[1], entry[2], value) && ok;
+    }
+  }
+  ok = endTransaction() && ok;
+  _txn = batch;
+
+  if (ok && _clock_plan_valid) {
+    pcm51xx_clock_plan_t plan = _clock_plan;
+    ok = applyClockPlan(&plan);
+  }
+
+  _recovering = false;
+  if (ok) {
+    _error_stats.restores++;
+  }
+  return ok;
+}
+
+/*!
+ * @brief Get and clear the last error
+ *
+ * Getters return a default value when the bus fails; this tells such a
+ * value apart from a real one.
+ *
+ * @return Last error since the previous call
+ */
+pcm51xx_error_t Adafruit_PCM51xx::getLastError(void) {
+  pcm51xx_error_t error = _last_error;
+  _last_error = PCM51XX_ERROR_NONE;
+  return error;
+}
+
+/*!
+ * @brief Get the bus error and recovery counters
+ * @return Counters since creation or the last resetErrorStats()
+ */
+pcm51xx_error_stats_t Adafruit_PCM51xx::getErrorStats(void) {
+  return _error_stats;
+}
+
+/*!
+ * @brief Clear the bus error and recovery counters
+ */
+void Adafruit_PCM51xx::resetErrorStats(void) {
+  memset(&_error_stats, 0, sizeof(_error_stats));
+}
+
+#ifdef PCM51XX_INSTRUMENT
+/*!
+ * @brief Start timing a public call
+ * @param dac DAC the call is made on
+ * @param api Call being timed
+ */
+Adafruit_PCM51xx::ApiTimer::ApiTimer(Adafruit_PCM51xx* dac,
+                                     pcm51xx_api_t api) {
+  _dac = dac;
+  _api = api;
+  _start = micros();
+}
+
+/*!
+ * @brief Record the call duration in its latency histogram
+ */
+Adafruit_PCM51xx::ApiTimer::~ApiTimer(void) {
+  uint32_t us = micros() - _start;
+  pcm51xx_api_stats_t* stats = &_dac->_instrument.api[_api];
+  stats->calls++;
+  stats->total_us += us;
+  if (us > stats->max_us) {
+    stats->max_us = us;
+  }
+
+  uint8_t bucket = 0;
+  for (uint32_t limit = 16; bucket < PCM51XX_HIST_BUCKETS - 1 && us >= limit;
+       limit <<= 2) {
+    bucket++;
+  }
+  if (stats->histogram[bucket] < 0xFFFF) {
+    stats->histogram[bucket]++;
+  }
+}
+
+/*!
+ * @brief Count a bus transfer against every register it touches
+ * @param addr Register address, including any auto-increment flag
+ * @param len Number of registers transferred
+ */
+void Adafruit_PCM51xx::countTransfer(uint8_t addr, uint8_t len) {
+  uint8_t reg = addr & 0x7F;
+  // The page select register is on every page
+  if (_page != 0 && reg != PCM51XX_REG_PAGE_SELECT) {
+    if (_instrument.other_page_transfers < 0xFFFF) {
+      _instrument.other_page_transfers++;
+    }
+    return;
+  }
+
+  for (uint8_t i = 0; i < len && reg + i < 128; i++) {
+    if (_instrument.reg_transfers[reg + i] < 0xFFFF) {
+      _instrument.reg_transfers[reg + i]++;
+    }
+  }
+}
+
+/*!
+ * @brief Take a snapshot of every instrumentation counter
+ *
+ * Only available when built with PCM51XX_INSTRUMENT. Per-register counters
+ * and histogram buckets stop at 65535.
+ *
+ * @param snapshot Where to store the counters
+ */
+void Adafruit_PCM51xx::getInstrumentation(pcm51xx_instrument_t* snapshot) {
+  *snapshot = _instrument;
+  snapshot->bus = _bus_stats;
+  snapshot->errors = _error_stats;
+}
+
+/*!
+ * @brief Clear every instrumentation counter, bus and error stats included
+ */
+void Adafruit_PCM51xx::resetInstrumentation(void) {
+  memset(&_instrument, 0, sizeof(_instrument));
+  resetBusStats();
+  resetErrorStats();
+}
+
+/*!
+ * @brief Print the instrumentation counters in a compact text format
+ *
+ * One comma-separated record per line, each starting with "pcm51xx" and
+ * its kind, so field captures can be grepped out of a mixed log:
+ *
+ *     pcm51xx,bus,transactions,reads,page_selects,bytes_written,bytes_read
+ *     pcm51xx,page,selects,avoided
+ *     pcm51xx,err,errors,retries,failures,resets,restores
+ *     pcm51xx,reg,other_pages,reg:count,... (hex registers, nonzero only)
+ *     pcm51xx,api,id,calls,total_us,max_us,bucket0,...,bucket7
+ *
+ * An api line is printed for each call made at least once.
+ *
+ * @param out Where to print, e.g. &Serial
+ */
+void Adafruit_PCM51xx::dumpInstrumentation(Print* out) {
+  out->print(F("pcm51xx,bus,"));
+  out->print(_bus_stats.transactions);
+  out->print(',');
+  out->print(_bus_stats.reads);
+  out->print(',');
+  out->print(_bus_stats.page_selects);
+  out->print(',');
+  out->print(_bus_stats.bytes_written);
+  out->print(',');
+  out->println(_bus_stats.bytes_read);
+
+  out->print(F("pcm51xx,page,"));
+  out->print(_bus_stats.page_selects);
+  out->print(',');
+  out->println(_instrument.pages_avoided);
+
+  out->print(F("pcm51xx,err,"));
+  out->print(_error_stats.errors);
+  out->print(',');
+  out->print(_error_stats.retries);
+  out->print(',');
+  out->print(_error_stats.failures);
+  out->print(',');
+  out->print(_error_stats.resets);
+  out->print(',');
+  out->println(_error_stats.restores);
+
+  out->print(F("pcm51xx,reg,"));
+  out->print(_instrument.other_page_transfers);
+  for (uint8_t reg = 0; reg < 128; reg++) {
+    if (_instrument.reg_transfers[reg]) {
+      out->print(',');
+      out->print(reg, HEX);
+      out->print(':');
+      out->print(_instrument.reg_transfers[reg]);
+    }
+  }
+  out->println();
+
+  for (uint8_t i = 0; i < PCM51XX_API_COUNT; i++) {
+    const pcm51xx_api_stats_t* stats = &_instrument.api[i];
+    if (!stats->calls) {
+      continue;
+    }
+    out->print(F("pcm51xx,api,"));
+    out->print(i);
+    out->print(',');
+    out->print(stats->calls);
+    out->print(',');
+    out->print(stats->total_us);
+    out->print(',');
+    out->print(stats->max_us);
+    for (uint8_t b = 0; b < PCM51XX_HIST_BUCKETS; b++) {
+      out->print(',');
+      out->print(stats->histogram[b]);
+    }
+    out->println();
+  }
+}
+#endif
+
+#ifdef PCM51XX_TRACE
+/*!
+ * @brief Start or stop recording register accesses
+ *
+ * Only available when built with PCM51XX_TRACE. Recording is on from
+ * construction, so begin() is traced too. Turning it back on starts a fresh
+ * trace, as the accesses made meanwhile would be missing from it.
+ *
+ * @param enable True to record, false to pause
+ */
+void Adafruit_PCM51xx::enableTrace(bool enable) {
+  BusLock lock(this);
+  if (enable && !_trace_enabled) {
+    clearTrace();
+  }
+  _trace_enabled = enable;
+}
+
+/*!
+ * @brief Drop every recorded register access
+ */
+void Adafruit_PCM51xx::clearTrace(void) {
+  BusLock lock(this);
+  _trace_head = 0;
+  _trace_count = 0;
+  _trace_dropped = 0;
+  _trace_time = micros();
+  _trace_page = _page;
+}
+
+/*!
+ * @brief Get the number of register accesses held by the trace
+ * @return Records in the ring buffer, at most PCM51XX_TRACE_SIZE
+ */
+uint16_t Adafruit_PCM51xx::getTraceCount(void) {
+  return _trace_count;
+}
+
+/*!
+ * @brief Print the trace for the pcm51xx_trace replay tool
+ *
+ * The records are printed oldest first as hex, 8 per line, between a
+ * header and an end line:
+ *
+ *     pcm51xx,trace,1,page,time_us,count,dropped
+ *     0082e803...
+ *     pcm51xx,trace,end
+ *
+ * where 1 is the format version, page the page selected before the first
+ * record (255 if unknown), time_us the micros() of the last record and
+ * dropped the number of older records overwritten.
+ *
+ * @param out Where to print, e.g. &Serial
+ */
+void Adafruit_PCM51xx::dumpTrace(Print* out) {
+  BusLock lock(this);
+  out->print(F("pcm51xx,trace,1,"));
+  out->print(_trace_page);
+  out->print(',');
+  out->print(_trace_time);
+  out->print(',');
+  out->print(_trace_count);
+  out->print(',');
+  out->println(_trace_dropped);
+
+  uint16_t index = (_trace_head + PCM51XX_TRACE_SIZE - _trace_count) %
+                   PCM51XX_TRACE_SIZE;
+  for (uint16_t i = 0; i < _trace_count; i++) {
+    const uint8_t* record = &_trace[index * PCM51XX_TRACE_RECORD];
+    for (uint8_t b = 0; b < PCM51XX_TRACE_RECORD; b++) {
+      if (record[b] < 0x10) {
+        out->print('0');
+      }
+      out->print(record[b], HEX);
+    }
+    if (i % 8 == 7 || i == _trace_count - 1) {
+      out->println();
+    }
+    index = (index + 1) % PCM51XX_TRACE_SIZE;
+  }
+  out->println(F("pcm51xx,trace,end"));
+}
+
+/*!
+ * @brief Append a bus transfer to the trace, one record per register
+ * @param addr Register address, including any auto-increment flag
+ * @param buffer Data written or read
+ * @param len Number of registers transferred
+ * @param write True for a write, false for a read
+ * @param ok True if the transfer succeeded
+ */
+void Adafruit_PCM51xx::traceTransfer(uint8_t addr, const uint8_t* buffer,
+                                     uint8_t len, bool write, bool ok) {
+  if (!_trace_enabled) {
+    return;
+  }
+
+  uint32_t now = micros();
+  uint32_t delta = now - _trace_time;
+  _trace_time = now;
+
+  uint8_t reg = addr & 0x7F;
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t* record = &_trace[_trace_head * PCM51XX_TRACE_RECORD];
+    if (_trace_count < PCM51XX_TRACE_SIZE) {
+      _trace_count++;
+    } else {
+      // Overwriting the oldest record, keep the page it leaves selected
+      if (record[0] == (PCM51XX_TRACE_WRITE | PCM51XX_REG_PAGE_SELECT)) {
+        _trace_page =
+            (record[3] & (PCM51XX_TRACE_FAILED >> 8)) ? 0xFF : record[1];
+      }
+      _trace_dropped++;
+    }
+
+    uint16_t word = delta > PCM51XX_TRACE_MAX_DELTA ? PCM51XX_TRACE_MAX_DELTA
+                                                    : (uint16_t)delta;
+    if (!ok) {
+      word |= PCM51XX_TRACE_FAILED;
+    }
+    record[0] = (write ? PCM51XX_TRACE_WRITE : 0) | ((reg + i) & 0x7F);
+    record[1] = (ok || write) ? buffer[i] : 0;
+    record[2] = word & 0xFF;
+    record[3] = word >> 8;
+
+    delta = 0; // The rest of a burst happened at the same time
+    if (++_trace_head == PCM51XX_TRACE_SIZE) {
+      _trace_head = 0;
+    }
+  }
+}
+#endif
+
+/*!
+ * @brief Read bytes starting at a register address on the current page
+ *
+ * Failed transfers are retried according to setRetryPolicy().
+ *
+ * @param addr Register address, including any auto-increment flag
+ * @param buffer Buffer to store the data
+ * @param len Number of bytes to read
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::busRead(uint8_t addr, uint8_t* buffer, uint8_t len) {
+  uint8_t page = _page;
+  for (uint8_t attempt = 0;; attempt++) {
+    if (restorePage(page) && rawRead(addr, buffer, len)) {
+      return true;
+    }
+    if (!handleBusError(attempt)) {
+      return false;
+    }
+  }
+}
+
+/*!
+ * @brief Write bytes starting at a register address on the current page
+ *
+ * Failed transfers are retried according to setRetryPolicy().
+ *
+ * @param addr Register address, including any auto-increment flag
+ * @param buffer Data to write
+ * @param len Number of bytes to write
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::busWrite(uint8_t addr, const uint8_t* buffer,
+                                uint8_t len) {
+  // A page select retry must not first go back to the old page
+  uint8_t page = addr == PCM51XX_REG_PAGE_SELECT ? 0xFF : _page;
+  for (uint8_t attempt = 0;; attempt++) {
+    if (restorePage(page) && rawWrite(addr, buffer, len)) {
+      return true;
+    }
+    if (!handleBusError(attempt)) {
+      return false;
+    }
+  }
+}
+
+/*!
+ * @brief Go back to a page after a failed transfer left it unknown
+ * @param page Page the transfer is meant for, or 0xFF for any
+ * @return True if the chip is on that page, false otherwise
+ */
+bool Adafruit_PCM51xx::restorePage(uint8_t page) {
+  if (page == 0xFF || _page == page) {
+    return true;
+  }
+
+  _bus_stats.page_selects++;
+  if (!rawWrite(PCM51XX_REG_PAGE_SELECT, &page, 1)) {
+    return false;
+  }
+  _page = page;
+  return true;
+}
+
+/*!
+ * @brief Account for a failed transfer and wait before retrying it
+ *
+ * The failed transfer may or may not have reached the chip, and a chip
+ * that browned out is back on page 0, so the cached page is forgotten.
+ *
+ * @param attempt Number of the attempt that failed, from 0
+ * @return True to retry, false to give up
+ */
+bool Adafruit_PCM51xx::handleBusError(uint8_t attempt) {
+  _error_stats.errors++;
+  _page = 0xFF;
+  _reset_check = _auto_recover;
+
+  if (attempt >= _retries) {
+    _error_stats.failures++;
+    _last_error = PCM51XX_ERROR_BUS;
+    return false;
+  }
+
+  _error_stats.retries++;
+  // Exponential backoff, kept within what delayMicroseconds() can do
+  uint32_t wait = (uint32_t)_retry_backoff << min(attempt, (uint8_t)7);
+  delayMicroseconds(wait > 16000 ? 16000 : wait);
+  return true;
+}
+
+/*!
+ * @brief Read raw bytes starting at a register address on the current page
+ *
+ * This is the only place the library reads from the bus.
+ *
+ * @param addr Register address, including any auto-increment flag
+ * @param buffer Buffer to store the data
+ * @param len Number of bytes to read
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::rawRead(uint8_t addr, uint8_t* buffer, uint8_t len) {
+#ifdef PCM51XX_INSTRUMENT
+  countTransfer(addr, len);
+#endif
+  _bus_stats.transactions++;
+  _bus_stats.reads++;
+  _bus_stats.bytes_written++;
+  _bus_stats.bytes_read += len;
+
+  bool ok = false;
+#ifndef PCM51XX_SPI_ONLY
+  if (i2c_dev) {
+    ok = i2c_dev->write_then_read(&addr, 1, buffer, len);
+  }
+#endif
+#ifndef PCM51XX_I2C_ONLY
+  if (spi_dev) {
+    // SPI reads are flagged by the top address bit
+    uint8_t spi_addr = addr | 0x80;
+    ok = spi_dev->write_then_read(&spi_addr, 1, buffer, len);
+  }
+#endif
+#ifdef PCM51XX_TRACE
+  traceTransfer(addr, buffer, len, false, ok);
+#endif
+  return ok;
+}
+
+/*!
+ * @brief Write raw bytes starting at a register address on the current page
+ *
+ * This is the only place the library writes to the bus.
+ *
+ * @param addr Register address, including any auto-increment flag
+ * @param buffer Data to write
+ * @param len Number of bytes to write
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::rawWrite(uint8_t addr, const uint8_t* buffer,
+                                uint8_t len) {
+#ifdef PCM51XX_INSTRUMENT
+  countTransfer(addr, len);
+#endif
+  _bus_stats.transactions++;
+  _bus_stats.bytes_written += 1 + len;
+
+  bool ok = false;
+#ifndef PCM51XX_SPI_ONLY
+  if (i2c_dev) {
+    ok = i2c_dev->write(buffer, len, true, &addr, 1);
+  }
+#endif
+#ifndef PCM51XX_I2C_ONLY
+  if (spi_dev) {
+    uint8_t spi_addr = addr & ~0x80;
+    ok = spi_dev->write(buffer, len, &spi_addr, 1);
+  }
+#endif
+#ifdef PCM51XX_TRACE
+  traceTransfer(addr, buffer, len, true, ok);
+#endif
+  return ok;
+}
+
+/*!
+ * @brief Largest burst a single bus transfer can carry
+ *
+ * I2C transfers are limited by the Wire buffer, which also holds the
+ * register address byte, and only auto-increment with the
+ * PCM51XX_AUTO_INCREMENT flag set. SPI bursts are unlimited and always
+ * auto-increment (datasheet, SPI sequential access), so 0 is returned for
+ * SPI and no flag is needed there.
+ *
+ * @return Maximum data bytes per I2C transfer, 0 for SPI
+ */
+uint8_t Adafruit_PCM51xx::maxTransfer(void) {
+#ifndef PCM51XX_SPI_ONLY
+  if (i2c_dev) {
+    size_t size = i2c_dev->maxBufferSize();
+    return size > 0xFF ? 0xFF : (uint8_t)size;
+  }
+#endif
+  return 0;
+}
+
+/*!
+ * @brief Set the lock guarding the bus and register state
+ *
+ * For sharing one DAC between RTOS tasks: every register access, including
+ * its page select and any read-modify-write, and every transaction commit
+ * runs with the lock held. The hooks are entered again by nested calls, so
+ * they must implement a recursive mutex. beginTransaction() still applies
+ * to whichever task makes the next calls; use an
+ * Adafruit_PCM51xx_CommandQueue per task instead to batch writes.
+ *
+ * @param lock Function taking the lock, or nullptr for no locking
+ * @param unlock Function releasing it, or nullptr for no locking
+ * @param arg Argument passed to both, e.g. the mutex handle
+ */
+void Adafruit_PCM51xx::setLock(pcm51xx_lock_fn_t lock,
+                               pcm51xx_lock_fn_t unlock, void* arg) {
+  _lock = lock;
+  _unlock = unlock;
+  _lock_arg = arg;
+}
+
+/*!
+ * @brief Take the lock set with setLock(), if any
+ * @param dac DAC whose lock to take
+ */
+Adafruit_PCM51xx::BusLock::BusLock(Adafruit_PCM51xx* dac) {
+  _dac = dac;
+  if (_dac->_lock) {
+    _dac->_lock(_dac->_lock_arg);
+  }
+}
+
+/*!
+ * @brief Release the lock taken by the constructor
+ */
+Adafruit_PCM51xx::BusLock::~BusLock(void) {
+  if (_dac->_unlock) {
+    _dac->_unlock(_dac->_lock_arg);
+  }
+}
+
+/*!
+ * @brief Enable or disable the register shadow cache
+ *
+ * When enabled, every register written or read on page 0 (and the low
+ * registers of page 1) is mirrored in RAM. Bit-field setters then need a
+ * single bus write instead of a read-modify-write, and getters of
+ * configuration registers are answered without touching the bus. Status
+ * registers are always read from the chip.
+ *
+ * @param enable True to enable the cache, false to disable it
+ */
+void Adafruit_PCM51xx::enableCache(bool enable) {
+#ifndef PCM51XX_NO_CACHE
+  invalidateCache();
+  _cache_enabled = enable;
+#else
+  (void)enable;
+#endif
+}
+
+/*!
+ * @brief Check if the register shadow cache is enabled
+ * @return True if the cache is enabled, false otherwise
+ */
+bool Adafruit_PCM51xx::isCacheEnabled(void) {
+#ifndef PCM51XX_NO_CACHE
+  return _cache_enabled;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * @brief Forget every cached register value
+ *
+ * Call this if the chip may have been changed behind the library's back,
+ * e.g. by another bus master or a power cycle. The next access to each
+ * register goes to the bus again.
+ */
+void Adafruit_PCM51xx::invalidateCache(void) {
+#ifndef PCM51XX_NO_CACHE
+  memset(_cache_valid, 0, sizeof(_cache_valid));
+#endif
+}
+
+/*!
+ * @brief Check if a register changes on its own (status, self-clearing bits)
+ * @param page Register page
+ * @param reg Register address
+ * @return True if the register must always be read from the chip
+ */
+bool Adafruit_PCM51xx::isVolatileRegister(uint8_t page, uint8_t reg) {
+  if (page != 0) {
+    return false;
+  }
+
+  switch (reg) {
+    case PCM51XX_REG_RESET:
+    case PCM51XX_REG_PLL: // PLL lock flag
+    case PCM51XX_REG_DSP_OVERFLOW:
+    case PCM51XX_REG_RATE_DETECT_1:
+    case PCM51XX_REG_RATE_DETECT_2:
+    case PCM51XX_REG_RATE_DETECT_3:
+    case PCM51XX_REG_RATE_DETECT_4:
+    case PCM51XX_REG_CLOCK_STATUS:
+    case PCM51XX_REG_ANALOG_MUTE:
+    case PCM51XX_REG_POWER_STATE:
+    case PCM51XX_REG_GPIO_INPUT:
+    case PCM51XX_REG_AUTO_MUTE_FLAG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*!
+ * @brief Find the shadow cache slot for a register
+ * @param page Register page
+ * @param reg Register address
+ * @return Slot index, or -1 if the register is not cached
+ */
+int16_t Adafruit_PCM51xx::cacheSlot(uint8_t page, uint8_t reg) {
+#ifdef PCM51XX_NO_CACHE
+  (void)page;
+  (void)reg;
+  return -1;
+#else
+  if (!_cache_enabled || reg == PCM51XX_REG_PAGE_SELECT || reg > 0x7F) {
+    return -1;
+  }
+
+  if (page == 0) {
+    // Self-clearing reset bits would re-trigger a reset on the next write
+    return (reg == PCM51XX_REG_RESET) ? -1 : reg;
+  }
+  if (page == 1 && reg < PCM51XX_CACHE_PAGE1_REGS) {
+    return 128 + reg;
+  }
+  return -1;
+#endif
+}
+
+/*!
+ * @brief Look up a register in the shadow cache without touching the bus
+ * @param page Register page
+ * @param reg Register address
+ * @param value Pointer to store the cached value
+ * @return True if the register is cached, false otherwise
+ */
+bool Adafruit_PCM51xx::peekCache(uint8_t page, uint8_t reg, uint8_t* value) {
+#ifndef PCM51XX_NO_CACHE
+  int16_t slot = cacheSlot(page, reg);
+  if (slot >= 0 && (_cache_valid[slot >> 3] & (1 << (slot & 7)))) {
+    *value = _cache[slot];
+    return true;
+  }
+#else
+  (void)page;
+  (void)reg;
+  (void)value;
+#endif
+  return false;
+}
+
+/*!
+ * @brief Record a register value in the shadow cache
+ * @param page Register page
+ * @param reg Register address
+ * @param value Value now held by the register
+ */
+void Adafruit_PCM51xx::storeCache(uint8_t page, uint8_t reg, uint8_t value) {
+#ifndef PCM51XX_NO_CACHE
+  int16_t slot = cacheSlot(page, reg);
+  if (slot >= 0) {
+    _cache[slot] = value;
+    _cache_valid[slot >> 3] |= (1 << (slot & 7));
+  }
+#else
+  (void)page;
+  (void)reg;
+  (void)value;
+#endif
+}
+
+/*!
+ * @brief Forget the cached value of a register
+ * @param page Register page
+ * @param reg Register address
+ */
+void Adafruit_PCM51xx::dropCache(uint8_t page, uint8_t reg) {
+#ifndef PCM51XX_NO_CACHE
+  int16_t slot = cacheSlot(page, reg);
+  if (slot >= 0) {
+    _cache_valid[slot >> 3] &= ~(1 << (slot & 7));
+  }
+#else
+  (void)page;
+  (void)reg;
+#endif
+}
+
+/*!
+ * @brief Read a full register
+ * @param page Register page
+ * @param reg Register address
+ * @param value Pointer to store the register value
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::readRegister(uint8_t page, uint8_t reg,
+                                    uint8_t* value) {
+  return readRegisters(page, reg, value, 1);
+}
+
+/*!
+ * @brief Write a full register
+ * @param page Register page
+ * @param reg Register address
+ * @param value Value to write
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::writeRegister(uint8_t page, uint8_t reg,
+                                     uint8_t value) {
+  return writeRegisters(page, reg, &value, 1);
+}
+
+/*!
+ * @brief Change the masked bits of a register
+ *
+ * The current value comes from the shadow cache when available, so a
+ * cached register costs one bus write instead of a read plus a write.
+ *
+ * @param page Register page
+ * @param reg Register address
+ * @param mask Bits to change
+ * @param value New value for the masked bits (already shifted into place)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::updateRegister(uint8_t page, uint8_t reg, uint8_t mask,
+                                      uint8_t value) {
+  BusLock lock(this);
+  if (_txn) {
+    // Inside a transaction the merge with the current value happens when
+    // the transaction is committed
+    if (_txn->update(page, reg, mask, value)) {
+      return true;
+    }
+    if (!commit(_txn)) {
+      return false;
+    }
+    return _txn->update(page, reg, mask, value);
+  }
+
+  // Read-only bits of volatile registers ignore writes, so the cached copy
+  // is good enough as a base here
+  uint8_t current;
+  if (!peekCache(page, reg, &current) && !readRegister(page, reg, &current)) {
+    return false;
+  }
+
+  return writeRegister(page, reg, (current & ~mask) | (value & mask));
+}
+
+/*!
+ * @brief Read consecutive registers in a single auto-increment burst
+ *
+ * If every register in the range is held in the shadow cache the values
+ * are returned without touching the bus.
+ *
+ * @param page Register page
+ * @param reg First register address
+ * @param buffer Buffer to store the register values
+ * @param len Number of registers to read
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::readRegisters(uint8_t page, uint8_t reg,
+                                     uint8_t* buffer, uint8_t len) {
+  PCM51XX_TIME_API(PCM51XX_API_READ);
+  BusLock lock(this);
+  recoverIfNeeded();
+  bool cached = true;
+  for (uint8_t i = 0; i < len && cached; i++) {
+    cached = !isVolatileRegister(page, reg + i) &&
+             peekCache(page, reg + i, &buffer[i]);
+  }
+  if (cached) {
+    return true;
+  }
+
+  if (!selectPage(page)) {
+    return false;
+  }
+
+  // The I2C device can only move maxBufferSize() bytes per transfer
+  uint8_t limit = maxTransfer();
+  uint8_t chunk = len;
+  if (limit && limit < chunk) {
+    chunk = limit;
+  }
+
+  for (uint16_t offset = 0; offset < len; offset += chunk) {
+    uint8_t n = min((uint8_t)(len - offset), chunk);
+    uint8_t addr = reg + offset;
+    if (limit && n > 1) {
+      addr |= PCM51XX_AUTO_INCREMENT;
+    }
+
+    if (!busRead(addr, buffer + offset, n)) {
+      return false;
+    }
+  }
+
+  for (uint8_t i = 0; i < len; i++) {
+    storeCache(page, reg + i, buffer[i]);
+  }
+  return true;
+}
+
+/*!
+ * @brief Write consecutive registers in a single auto-increment burst
+ * @param page Register page
+ * @param reg First register address
+ * @param buffer Values to write
+ * @param len Number of registers to write
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::writeRegisters(uint8_t page, uint8_t reg,
+                                      const uint8_t* buffer, uint8_t len) {
+  PCM51XX_TIME_API(PCM51XX_API_WRITE);
+  BusLock lock(this);
+  recoverIfNeeded();
+  if (_txn) {
+    for (uint8_t i = 0; i < len; i++) {
+      if (!updateRegister(page, reg + i, 0xFF, buffer[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (!selectPage(page)) {
+    return false;
+  }
+
+  // One byte of each I2C transfer is taken by the register address
+  uint8_t limit = maxTransfer();
+  uint8_t chunk = len;
+  if (limit && limit - 1 < chunk) {
+    chunk = limit - 1;
+  }
+
+  bool ok = true;
+  for (uint16_t offset = 0; offset < len && ok; offset += chunk) {
+    uint8_t n = min((uint8_t)(len - offset), chunk);
+    uint8_t addr = reg + offset;
+    if (limit && n > 1) {
+      addr |= PCM51XX_AUTO_INCREMENT;
+    }
+
+    ok = busWrite(addr, buffer + offset, n);
+  }
+
+  // On failure we don't know how far the burst got, so forget the range
+  for (uint8_t i = 0; i < len; i++) {
+    if (ok) {
+      storeCache(page, reg + i, buffer[i]);
+    } else {
+      dropCache(page, reg + i);
+    }
+    noteWrite(page, reg + i, buffer[i], ok);
+  }
+  return ok;
+}
+
+/*!
+ * @brief Start collecting register writes into a transaction
+ *
+ * Until endTransaction() is called, setters queue their writes in txn
+ * instead of sending them. Getters still read the committed state of the
+ * chip. If txn fills up it is committed early and reused.
+ *
+ * @param txn Transaction to collect writes into
+ */
+void Adafruit_PCM51xx::beginTransaction(Adafruit_PCM51xx_Transaction* txn) {
+  _txn = txn;
+}
+
+/*!
+ * @brief Stop collecting writes and commit the pending transaction
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::endTransaction(void) {
+  Adafruit_PCM51xx_Transaction* txn = _txn;
+  _txn = nullptr;
+  if (!txn) {
+    return true;
+  }
+  return commit(txn);
+}
+
+/*!
+ * @brief Send all writes queued in a transaction and clear it
+ *
+ * Registers are written in page then address order. Each run of
+ * contiguous registers on a page goes out as one auto-increment burst.
+ * Partial writes are merged with the current register value (from the
+ * shadow cache when available).
+ *
+ * @param txn Transaction to commit
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::commit(Adafruit_PCM51xx_Transaction* txn) {
+  PCM51XX_TIME_API(PCM51XX_API_COMMIT);
+  bool ok = send(txn);
+  txn->clear();
+  return ok;
+}
+
+/*!
+ * @brief Send all writes queued in a transaction, keeping it intact
+ *
+ * Lets the same transaction be sent to several chips.
+ *
+ * @param txn Transaction to send
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_PCM51xx::send(const Adafruit_PCM51xx_Transaction* txn) {
+  BusLock lock(this);
+  // Writes issued while sending must hit the bus, not the transaction
+  Adafruit_PCM51xx_Transaction* batch = _txn;
+  _txn = nullptr;
+
+  bool ok = true;
+  uint8_t i = 0;
+  while (ok && i < txn->_count) {
+    uint8_t values[PCM51XX_TRANSACTION_SIZE];
+    const pcm51xx_reg_write_t* first = &txn->_writes[i];
+    uint8_t n = 0;
+
+    while (ok && i + n < txn->_count) {
+      const pcm51xx_reg_write_t* w = &txn->_writes[i + n];
+      if (w->page != first->page || w->reg != first->reg + n) {
+        break;
+      }
+
+      values[n] = w->value;
+      if (w->mask != 0xFF) {
+        uint8_t current;
+        ok = readRegister(w->page, w->reg, &current);
+        values[n] = (current & ~w->mask) | (w->value & w->mask);
+      }
+      n++;
+    }
+
+    ok = ok && writeRegisters(first->page, first->reg, values, n);
+    i += n;
+  }
+
+  _txn = batch;
+  return ok;
+}
+
+/*!
+ * @brief Constructor for an empty transaction
+ */
+Adafruit_PCM51xx_Transaction::Adafruit_PCM51xx_Transaction(void) {
+  _count = 0;
+}
+
+/*!
+ * @brief Drop all queued writes
+ */
+void Adafruit_PCM51xx_Transaction::clear(void) {
+  _count = 0;
+}
+
+/*!
+ * @brief Get the number of distinct registers queued
+ * @return Number of queued register writes
+ */
+uint8_t Adafruit_PCM51xx_Transaction::count(void) {
+  return _count;
+}
+
+/*!
+ * @brief Queue a full register write
+ * @param page Register page
+ * @param reg Register address
+ * @param value Value to write
+ * @return True if queued, false if the transaction is full
+ */
+bool Adafruit_PCM51xx_Transaction::write(uint8_t page, uint8_t reg,
+                                         uint8_t value) {
+  return update(page, reg, 0xFF, value);
+}
+
+/*!
+ * @brief Queue a write of the masked bits of a register
+ *
+ * A second write to an already queued register is merged into the
+ * existing entry, later bits taking precedence.
+ *
+ * @param page Register page
+ * @param reg Register address
+ * @param mask Bits to change
+ * @param value New value for the masked bits (already shifted into place)
+ * @return True if queued, false if the transaction is full
+ */
+bool Adafruit_PCM51xx_Transaction::update(uint8_t page, uint8_t reg,
+                                          uint8_t mask, uint8_t value) {
+  // Keep the list sorted by page, then address
+  uint8_t pos = 0;
+  while (pos < _count &&
+         (_writes[pos].page < page ||
+          (_writes[pos].page == page && _writes[pos].reg < reg))) {
+    pos++;
+  }
+
+  if (pos < _count && _writes[pos].page == page && _writes[pos].reg == reg) {
+    _writes[pos].value = (_writes[pos].value & ~mask) | (value & mask);
+    _writes[pos].mask |= mask;
+    return true;
+  }
+
+  if (_count >= PCM51XX_TRANSACTION_SIZE) {
+    return false;
+  }
+
+  memmove(&_writes[pos + 1], &_writes[pos],
+          (_count - pos) * sizeof(pcm51xx_reg_write_t));
+  _writes[pos].page = page;
+  _writes[pos].reg = reg;
+  _writes[pos].mask = mask;
+  _writes[pos].value = value & mask;
+  _count++;
+  return true;
+}
+
+/*!
+ * @brief Queue a write of a register bit field
+ * @param page Register page
+ * @param reg Register address
+ * @param bits Width of the field in bits
+ * @param shift Position of the field's lowest bit
+ * @param value New field value
+ * @return True if queued, false if the transaction is full
+ */
+bool Adafruit_PCM51xx_Transaction::writeBits(uint8_t page, uint8_t reg,
+                                             uint8_t bits, uint8_t shift,
+                                             uint8_t value) {
+  uint8_t mask = ((1 << bits) - 1) << shift;
+  return update(page, reg, mask, value << shift);
+}
+
+/*!
+ * @brief Constructor for an empty DAC array
+ */
+Adafruit_PCM51xx_Array::Adafruit_PCM51xx_Array(void) {
+  _count = 0;
+  _failed = 0;
+}
+
+/*!
+ * @brief Add a DAC to the array
+ *
+ * The DAC must already be started with begin(). DACs are numbered in the
+ * order they are added, which is also the channel order of
+ * setVolumeMap().
+ *
+ * @param dac DAC to add
+ * @return True if added, false if the array is full
+ */
+bool Adafruit_PCM51xx_Array::add(Adafruit_PCM51xx* dac) {
+  if (!dac || _count >= PCM51XX_ARRAY_MAX) {
+    return false;
+  }
+  _dacs[_count++] = dac;
+  return true;
+}
+
+/*!
+ * @brief Get the number of DACs in the array
+ * @return Number of DACs
+ */
+uint8_t Adafruit_PCM51xx_Array::count(void) {
+  return _count;
+}
+
+/*!
+ * @brief Get a DAC of the array
+ * @param index DAC number, in the order they were added
+ * @return The DAC, or nullptr if index is out of range
+ */
+Adafruit_PCM51xx* Adafruit_PCM51xx_Array::device(uint8_t index) {
+  return index < _count ? _dacs[index] : nullptr;
+}
+
+/*!
+ * @brief Get the DACs that failed the last array operation
+ * @return Bit n set if DAC n failed
+ */
+uint8_t Adafruit_PCM51xx_Array::getFailed(void) {
+  return _failed;
+}
+
+/*!
+ * @brief Send the same batch of writes to every DAC
+ *
+ * The transaction is sorted and merged once; each DAC then gets the same
+ * bursts. Partial register writes are merged with each DAC's own register
+ * value. The transaction is cleared afterwards.
+ *
+ * @param txn Writes to apply
+ * @return True if every DAC accepted them, false otherwise (see
+ *         getFailed())
+ */
+bool Adafruit_PCM51xx_Array::apply(Adafruit_PCM51xx_Transaction* txn) {
+  _failed = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_dacs[i]->send(txn)) {
+      _failed |= 1 << i;
+    }
+  }
+  txn->clear();
+  return !_failed;
+}
+
+/*!
+ * @brief Set or release the clock divider sync request on every DAC
+ *
+ * The sync request register holds nothing else, so each DAC takes a single
+ * write and a release reaches all of them back to back.
+ *
+ * @param hold True to halt the clock dividers, false to restart them
+ * @return True if every DAC accepted it, false otherwise
+ */
+bool Adafruit_PCM51xx_Array::holdSync(bool hold) {
+  uint8_t value = PCM51XX_FIELD_SYNC_REQ::place(hold ? 1 : 0);
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_dacs[i]->writeRegister(0, PCM51XX_REG_SYNC_REQ, value)) {
+      _failed |= 1 << i;
+    }
+  }
+  return !_failed;
+}
+
+/*!
+ * @brief Program the same clock tree on every DAC and restart them together
+ *
+ * All DACs are put in standby with their clock dividers halted, the clock
+ * registers are queued once and sent to each DAC, and after every DAC has
+ * left standby the dividers are released back to back.
+ *
+ * @param plan Clock plan from Adafruit_PCM51xx::planClocks()
+ * @return True if successful, false if the plan is invalid or a DAC failed
+ *         (see getFailed())
+ */
+bool Adafruit_PCM51xx_Array::applyClockPlan(const pcm51xx_clock_plan_t* plan) {
+  _failed = 0;
+  Adafruit_PCM51xx_Transaction txn;
+  if (!Adafruit_PCM51xx::validateClockPlan(plan) ||
+      !queueClockPlan(plan, &txn)) {
+    return false;
+  }
+
+  holdSync(true);
+  for (uint8_t i = 0; i < _count; i++) {
+    Adafruit_PCM51xx* dac = _dacs[i];
+    bool ok = dac->standby(true) && dac->send(&txn) && dac->standby(false);
+    if (ok) {
+      dac->_clock_plan = *plan;
+    } else {
+      _failed |= 1 << i;
+    }
+    dac->_clock_plan_valid = ok;
+  }
+  holdSync(false);
+  return !_failed;
+}
+
+/*!
+ * @brief Restart the clock dividers of every DAC together
+ *
+ * Realigns the DACs, e.g. after one of them was reconfigured on its own.
+ *
+ * @return True if successful, false otherwise (see getFailed())
+ */
+bool Adafruit_PCM51xx_Array::resync(void) {
+  _failed = 0;
+  holdSync(true);
+  holdSync(false);
+  return !_failed;
+}
+
+/*!
+ * @brief Set the volume of every channel
+ *
+ * Each DAC gets its left and right volume in one two-register burst.
+ *
+ * @param half_db Volume of each channel in 0.5dB steps, two per DAC (left
+ *        then right) in the order the DACs were added
+ * @param offset Added to every channel, e.g. a master volume in 0.5dB steps
+ * @return True if successful, false otherwise (see getFailed())
+ */
+bool Adafruit_PCM51xx_Array::setVolumeMap(const int16_t* half_db,
+                                          int16_t offset) {
+  _failed = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_dacs[i]->setVolumeHalfDB(half_db[i * 2] + offset,
+                                   half_db[i * 2 + 1] + offset)) {
+      _failed |= 1 << i;
+    }
+  }
+  return !_failed;
+}
+
+/*!
+ * @brief Mute or unmute every DAC
+ * @param enable True to mute, false to unmute
+ * @return True if successful, false otherwise (see getFailed())
+ */
+bool Adafruit_PCM51xx_Array::mute(bool enable) {
+  Adafruit_PCM51xx_Transaction txn;
+  txn.writeField<PCM51XX_FIELD_MUTE_LEFT>(enable ? 1 : 0);
+  txn.writeField<PCM51XX_FIELD_MUTE_RIGHT>(enable ? 1 : 0);
+  return apply(&txn);
+}
+
+/*!
+ * @brief Constructor for the default transport
+ * @param dac DAC whose I2C or SPI device carries the transfers
+ */
+Adafruit_PCM51xx_BusTransport::Adafruit_PCM51xx_BusTransport(
+    Adafruit_PCM51xx* dac) {
+  _dac = dac;
+  _result = PCM51XX_TRANSFER_DONE;
+}
+
+/*!
+ * @brief Write consecutive registers, blocking until done
+ * @param reg First register address
+ * @param buffer Data to write
+ * @param len Number of bytes
+ * @return Always true; the result is reported by poll()
+ */
+bool Adafruit_PCM51xx_BusTransport::startWrite(uint8_t reg,
+                                               const uint8_t* buffer,
+                                               uint8_t len) {
+  if (len > 1 && _dac->maxTransfer()) {
+    reg |= PCM51XX_AUTO_INCREMENT;
+  }
+  _result = _dac->busWrite(reg, buffer, len) ? PCM51XX_TRANSFER_DONE
+                                             : PCM51XX_TRANSFER_ERROR;
+  return true;
+}
+
+/*!
+ * @brief Read consecutive registers, blocking until done
+ * @param reg First register address
+ * @param buffer Buffer to store the data
+ * @param len Number of bytes
+ * @return Always true; the result is reported by poll()
+ */
+bool Adafruit_PCM51xx_BusTransport::startRead(uint8_t reg, uint8_t* buffer,
+                                              uint8_t len) {
+  if (len > 1 && _dac->maxTransfer()) {
+    reg |= PCM51XX_AUTO_INCREMENT;
+  }
+  _result = _dac->busRead(reg, buffer, len) ? PCM51XX_TRANSFER_DONE
+                                            : PCM51XX_TRANSFER_ERROR;
+  return true;
+}
+
+/*!
+ * @brief Get the result of the last transfer
+ * @return PCM51XX_TRANSFER_DONE or PCM51XX_TRANSFER_ERROR
+ */
+pcm51xx_transfer_t Adafruit_PCM51xx_BusTransport::poll(void) {
+  return _result;
+}
+
+/*!
+ * @brief Constructor for an empty operation queue
+ * @param dac DAC to drive, already started with begin()
+ * @param transport Transport carrying the transfers, or nullptr for the
+ *        DAC's own bus device
+ */
+Adafruit_PCM51xx_Async::Adafruit_PCM51xx_Async(
+    Adafruit_PCM51xx* dac, Adafruit_PCM51xx_Transport* transport)
+    : _bus(dac) {
+  _dac = dac;
+  _transport = transport ? transport : &_bus;
+  _head = 0;
+  _count = 0;
+  _busy = false;
+  _paging = false;
+  resetStats();
+}
+
+/*!
+ * @brief Queue a full register write
+ * @param page Register page
+ * @param reg Register address
+ * @param value Value to write
+ * @param callback Function called once written, or nullptr
+ * @param arg Argument passed to the callback
+ * @return True if queued, false if the queue is full
+ */
+bool Adafruit_PCM51xx_Async::write(uint8_t page, uint8_t reg, uint8_t value,
+                                   pcm51xx_async_callback_t callback,
+                                   void* arg) {
+  pcm51xx_async_op_t op = {page, reg, value, false, nullptr, callback, arg};
+  return push(&op);
+}
+
+/*!
+ * @brief Queue a register read
+ * @param page Register page
+ * @param reg Register address
+ * @param value Where to store the value once read, or nullptr
+ * @param callback Function called with the value once read, or nullptr
+ * @param arg Argument passed to the callback
+ * @return True if queued, false if the queue is full
+ */
+bool Adafruit_PCM51xx_Async::read(uint8_t page, uint8_t reg, uint8_t* value,
+                                  pcm51xx_async_callback_t callback,
+                                  void* arg) {
+  pcm51xx_async_op_t op = {page, reg, 0, true, value, callback, arg};
+  return push(&op);
+}
+
+/*!
+ * @brief Add an operation to the end of the queue
+ * @param op Operation to add
+ * @return True if queued, false if the queue is full
+ */
+bool Adafruit_PCM51xx_Async::push(const pcm51xx_async_op_t* op) {
+  if (_count >= PCM51XX_ASYNC_QUEUE_SIZE) {
+    return false;
+  }
+
+  _ops[(_head + _count) % PCM51XX_ASYNC_QUEUE_SIZE] = *op;
+  _count++;
+  _stats.queued++;
+  if (_count > _stats.max_depth) {
+    _stats.max_depth = _count;
+  }
+  return true;
+}
+
+/*!
+ * @brief Start the next transfer of the oldest operation
+ *
+ * A page select goes first if the chip is on another page.
+ *
+ * @return True if the transfer was started, false otherwise
+ */
+bool Adafruit_PCM51xx_Async::start(void) {
+  pcm51xx_async_op_t* op = &_ops[_head];
+  _paging = _dac->_page != op->page;
+
+  uint32_t start = micros();
+  bool ok;
+  if (_paging) {
+    _page = op->page;
+    ok = _transport->startWrite(PCM51XX_REG_PAGE_SELECT, &_page, 1);
+  } else if (op->read) {
+    ok = _transport->startRead(op->reg, &op->value, 1);
+  } else {
+    ok = _transport->startWrite(op->reg, &op->value, 1);
+  }
+  _stats.blocked_us += micros() - start;
+  _stats.transfers++;
+
+  _busy = ok;
+  return ok;
+}
+
+/*!
+ * @brief Complete the oldest operation and call its callback
+ * @param ok True if it succeeded
+ */
+void Adafruit_PCM51xx_Async::finish(bool ok) {
+  // Popped first so the callback may queue more operations
+  pcm51xx_async_op_t op = _ops[_head];
+  _head = (_head + 1) % PCM51XX_ASYNC_QUEUE_SIZE;
+  _count--;
+
+  if (ok) {
+    _stats.completed++;
+    if (!op.read || !Adafruit_PCM51xx::isVolatileRegister(op.page, op.reg)) {
+      _dac->storeCache(op.page, op.reg, op.value);
+    }
+    if (op.dest) {
+      *op.dest = op.value;
+    }
+  } else {
+    _stats.failed++;
+    if (!op.read) {
+      _dac->dropCache(op.page, op.reg);
+    }
+  }
+  if (!op.read) {
+    _dac->noteWrite(op.page, op.reg, op.value, ok);
+  }
+
+  if (op.callback) {
+    op.callback(ok, op.value, op.arg);
+  }
+}
+
+/*!
+ * @brief Advance the queue
+ *
+ * Checks the transfer in flight and, once it has ended, starts the next
+ * one. At most one transfer is started per call, so with a blocking
+ * transport each call costs one bus transfer.
+ *
+ * @return True while operations are pending, false once the queue is empty
+ */
+bool Adafruit_PCM51xx_Async::poll(void) {
+  if (_busy) {
+    uint32_t start = micros();
+    pcm51xx_transfer_t result = _transport->poll();
+    _stats.blocked_us += micros() - start;
+    if (result == PCM51XX_TRANSFER_BUSY) {
+      return true;
+    }
+
+    _busy = false;
+    bool ok = result == PCM51XX_TRANSFER_DONE;
+    if (_paging) {
+      // A failed page select leaves the chip on an unknown page
+      _dac->_page = ok ? _page : 0xFF;
+    }
+    if (!_paging || !ok) {
+      finish(ok);
+    }
+  }
+
+  while (_count && !_busy) {
+    pcm51xx_async_op_t* op = &_ops[_head];
+    if (op->read && !Adafruit_PCM51xx::isVolatileRegister(op->page, op->reg) &&
+        _dac->peekCache(op->page, op->reg, &op->value)) {
+      finish(true);
+    } else if (!start()) {
+      finish(false);
+    }
+  }
+  return _count != 0;
+}
+
+/*!
+ * @brief Run the queue until it is empty
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return True if every operation completed in time, false on timeout
+ */
+bool Adafruit_PCM51xx_Async::flush(uint32_t timeout_ms) {
+  uint32_t start = millis();
+  while (poll()) {
+    if (millis() - start >= timeout_ms) {
+      return false;
+    }
+    yield();
+  }
+  return true;
+}
+
+/*!
+ * @brief Get the number of operations not yet completed
+ * @return Queued operations, including the one in flight
+ */
+uint8_t Adafruit_PCM51xx_Async::pending(void) {
+  return _count;
+}
+
+/*!
+ * @brief Get the queue counters
+ *
+ * completed / elapsed time gives the throughput; blocked_us is the CPU time
+ * spent waiting inside the transport, which drops to near zero with a
+ * DMA or interrupt-driven transport.
+ *
+ * @return Counters since creation or the last resetStats()
+ */
+pcm51xx_async_stats_t Adafruit_PCM51xx_Async::getStats(void) {
+  return _stats;
+}
+
+/*!
+ * @brief Clear the queue counters
+ */
+void Adafruit_PCM51xx_Async::resetStats(void) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/*!
+ * @brief Constructor for an empty command queue
+ */
+Adafruit_PCM51xx_CommandQueue::Adafruit_PCM51xx_CommandQueue(void) {
+  static_assert((PCM51XX_COMMAND_QUEUE_SIZE &
+                 (PCM51XX_COMMAND_QUEUE_SIZE - 1)) == 0 &&
+                    PCM51XX_COMMAND_QUEUE_SIZE <= 128,
+                "PCM51XX_COMMAND_QUEUE_SIZE must be a power of 2 up to 128");
+  _head = 0;
+  _tail = 0;
+  _dropped = 0;
+}
+
+/*!
+ * @brief Post a write of the masked bits of a register
+ *
+ * Only the producer task may call this. It never blocks and never touches
+ * the bus.
+ *
+ * drain() merges posted writes by register and sends them in page then
+ * address order, so only the last value posted to each register reaches
+ * the chip. A sequence that relies on ordering collapses: standby(1), clock
+ * writes, standby(0) becomes a single standby write of 0 and the chip never
+ * enters standby. Run such sequences from the task owning the DAC instead.
+ *
+ * @param page Register page
+ * @param reg Register address
+ * @param mask Bits to change (0xFF for a full register write)
+ * @param value New value for the masked bits (already shifted into place)
+ * @return True if posted, false if the queue is full
+ */
+bool Adafruit_PCM51xx_CommandQueue::post(uint8_t page, uint8_t reg,
+                                         uint8_t mask, uint8_t value) {
+  uint8_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+  uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+  if ((uint8_t)(head - tail) >= PCM51XX_COMMAND_QUEUE_SIZE) {
+    // Only the producer writes the counter, so a load and a store do; an
+    // atomic add would need a libcall that ARMv6-M and AVR do not provide
+    uint32_t dropped = __atomic_load_n(&_dropped, __ATOMIC_RELAXED);
+    __atomic_store_n(&_dropped, dropped + 1, __ATOMIC_RELAXED);
+    return false;
+  }
+
+  pcm51xx_reg_write_t* w = &_writes[head % PCM51XX_COMMAND_QUEUE_SIZE];
+  w->page = page;
+  w->reg = reg;
+  w->mask = mask;
+  w->value = value;
+  // Publish the slot only once it is filled in
+  __atomic_store_n(&_head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+  return true;
+}
+
+/*!
+ * @brief Apply every posted write to the DAC
+ *
+ * Only the task owning the DAC may call this. Writes are sent as one
+ * transaction (committed early if more than PCM51XX_TRANSACTION_SIZE
+ * registers are involved).
+ *
+ * @param dac DAC to write to
+ * @return True if successful or nothing was posted, false otherwise
+ */
+bool Adafruit_PCM51xx_CommandQueue::drain(Adafruit_PCM51xx* dac) {
+  uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+  uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+  if (tail == head) {
+    return true;
+  }
+
+  Adafruit_PCM51xx_Transaction txn;
+  bool ok = true;
+  for (; tail != head; tail++) {
+    const pcm51xx_reg_write_t* w = &_writes[tail % PCM51XX_COMMAND_QUEUE_SIZE];
+    if (!txn.update(w->page, w->reg, w->mask, w->value)) {
+      ok = dac->commit(&txn) && ok;
+      txn.update(w->page, w->reg, w->mask, w->value);
+    }
+  }
+  // Slots are copied out, so the producer may reuse them already
+  __atomic_store_n(&_tail, tail, __ATOMIC_RELEASE);
+
+  return dac->commit(&txn) && ok;
+}
+
+/*!
+ * @brief Get the number of writes posted but not yet drained
+ * @return Pending writes
+ */
+uint8_t Adafruit_PCM51xx_CommandQueue::pending(void) {
+  return (uint8_t)(__atomic_load_n(&_head, __ATOMIC_ACQUIRE) -
+                   __atomic_load_n(&_tail, __ATOMIC_ACQUIRE));
+}
+
+/*!
+ * @brief Get the number of writes rejected because the queue was full
+ * @return Dropped writes since creation
+ */
+uint32_t Adafruit_PCM51xx_CommandQueue::getDropped(void) {
+  return __atomic_load_n(&_dropped, __ATOMIC_RELAXED);
+}
@@ -7,11 +7,28 @@
 #ifndef _ADAFRUIT_PCM51XX_H
 #define _ADAFRUIT_PCM51XX_H
 
-#include <Adafruit_BusIO_Register.h>
+/*
+ * Footprint build options, set as compiler flags for the whole build (e.g.
+ * -DPCM51XX_I2C_ONLY) so the library sources see them too:
+ *
+ * PCM51XX_I2C_ONLY - drop SPI support (no SPI.h / Adafruit_SPIDevice)
+ * PCM51XX_SPI_ONLY - drop I2C support (no Wire.h / Adafruit_I2CDevice)
+ * PCM51XX_NO_CACHE - drop the register shadow cache and its RAM
+ * PCM51XX_INSTRUMENT - add per-register counters and API latency histograms
+ * PCM51XX_TRACE - record every register access in a ring buffer
+ */
+#if defined(PCM51XX_I2C_ONLY) && defined(PCM51XX_SPI_ONLY)
+#error "PCM51XX_I2C_ONLY and PCM51XX_SPI_ONLY are mutually exclusive"
+#endif
+
+#ifndef PCM51XX_SPI_ONLY
 #include <Adafruit_I2CDevice.h>
+#include <Wire.h>
+#endif
+#ifndef PCM51XX_I2C_ONLY
 #include <Adafruit_SPIDevice.h>
 #include <SPI.h>
-#include <Wire.h>
+#endif
 
 #include "Arduino.h"
 
@@ -62,6 +79,68 @@ typedef enum {
   PCM51XX_DAC_CLK_BCK = 4     ///< BCK clock
 } pcm51xx_dac_clk_src_t;
 
+/*! @brief Non-blocking operation, see startOperation() */
+typedef enum {
+  PCM51XX_OP_NONE = 0,            ///< No operation started
+  PCM51XX_OP_RESET_MODULES = 1,   ///< Module reset (RSTM)
+  PCM51XX_OP_RESET_REGISTERS = 2, ///< Register reset (RSTR)
+  PCM51XX_OP_EXIT_STANDBY = 3,    ///< Leave standby
+  PCM51XX_OP_EXIT_POWERDOWN = 4,  ///< Leave powerdown
+  PCM51XX_OP_WAIT_PLAYING = 5     ///< Wait for the run (playing) state
+} pcm51xx_op_t;
+
+/*! @brief Non-blocking operation progress */
+typedef enum {
+  PCM51XX_OP_IDLE = 0,    ///< Nothing started
+  PCM51XX_OP_BUSY = 1,    ///< Still in progress, keep polling
+  PCM51XX_OP_DONE = 2,    ///< Completed
+  PCM51XX_OP_TIMEOUT = 3, ///< Did not complete in time
+  PCM51XX_OP_ERROR = 4    ///< Could not be started
+} pcm51xx_op_status_t;
+
+/*! @brief Hardware volume ramp update rate */
+typedef enum {
+  PCM51XX_RAMP_EVERY_1FS = 0, ///< One step every sample
+  PCM51XX_RAMP_EVERY_2FS = 1, ///< One step every 2 samples
+  PCM51XX_RAMP_EVERY_4FS = 2, ///< One step every 4 samples
+  PCM51XX_RAMP_INSTANT = 3    ///< No ramp, jump straight to the new volume
+} pcm51xx_ramp_rate_t;
+
+/*! @brief Hardware volume ramp step size */
+typedef enum {
+  PCM51XX_RAMP_STEP_4DB = 0,  ///< 4dB per step
+  PCM51XX_RAMP_STEP_2DB = 1,  ///< 2dB per step
+  PCM51XX_RAMP_STEP_1DB = 2,  ///< 1dB per step
+  PCM51XX_RAMP_STEP_0_5DB = 3 ///< 0.5dB per step
+} pcm51xx_ramp_step_t;
+
+/*! @brief Software fade curve, see startFade() */
+typedef enum {
+  PCM51XX_FADE_LINEAR = 0,   ///< Constant dB per unit of time
+  PCM51XX_FADE_SMOOTH = 1,   ///< Slow start and end (smoothstep in dB)
+  PCM51XX_FADE_AMPLITUDE = 2 ///< Constant amplitude change per unit of time
+} pcm51xx_fade_curve_t;
+
+/*! @brief Biquad filter type, see designBiquad() */
+typedef enum {
+  PCM51XX_BIQUAD_PEAKING = 0,    ///< Peaking EQ
+  PCM51XX_BIQUAD_LOW_SHELF = 1,  ///< Low shelf
+  PCM51XX_BIQUAD_HIGH_SHELF = 2, ///< High shelf
+  PCM51XX_BIQUAD_LOW_PASS = 3,   ///< Second order low pass
+  PCM51XX_BIQUAD_HIGH_PASS = 4   ///< Second order high pass
+} pcm51xx_biquad_type_t;
+
+/*! @brief Detected Sample Rate (Read Only) */
+typedef enum {
+  PCM51XX_FS_ERROR = 0,     ///< Out of range
+  PCM51XX_FS_8K = 1,        ///< 8kHz
+  PCM51XX_FS_16K = 2,       ///< 16kHz
+  PCM51XX_FS_32K_48K = 3,   ///< 32kHz - 48kHz
+  PCM51XX_FS_88K_96K = 4,   ///< 88.2kHz - 96kHz
+  PCM51XX_FS_176K_192K = 5, ///< 176.4kHz - 192kHz
+  PCM51XX_FS_384K = 6       ///< 384kHz
+} pcm51xx_fs_detect_t;
+
 /*! @brief GPIO5 Output Selection */
 typedef enum {
   PCM51XX_GPIO5_OFF = 0x00,             ///< Off (low)
@@ -81,6 +160,33 @@ typedef enum {
   PCM51XX_GPIO5_PLL_OUT_DIV4 = 0x10     ///< PLL Output/4 (requires Clock Flex)
 } pcm51xx_gpio5_output_t;
 
+/*! @brief Status events signalled through GPIO flag outputs */
+typedef enum {
+  PCM51XX_EVENT_PLL_UNLOCK = 0,   ///< PLL lost lock
+  PCM51XX_EVENT_CLOCK_ERROR = 1,  ///< Clock invalid
+  PCM51XX_EVENT_AUTO_MUTE = 2,    ///< Auto mute engaged (both channels)
+  PCM51XX_EVENT_UNDER_VOLTAGE = 3 ///< DVDD below 0.7 of its nominal value
+} pcm51xx_event_t;
+
+/*! @brief Number of pcm51xx_event_t events */
+#define PCM51XX_EVENT_COUNT 4
+
+/*! @brief Number of MCU interrupt pins shared by all PCM51xx instances */
+#define PCM51XX_EVENT_PINS 4
+
+/*!
+ * @brief Event callback, see onEvent()
+ * @param event Event that changed
+ * @param active True if the condition started, false if it cleared
+ */
+typedef void (*pcm51xx_event_callback_t)(pcm51xx_event_t event, bool active);
+
+/*!
+ * @brief Lock or unlock hook, see setLock()
+ * @param arg Argument given to setLock()
+ */
+typedef void (*pcm51xx_lock_fn_t)(void* arg);
+
 /*! @brief Page 0 Register Addresses */
 #define PCM51XX_REG_PAGE_SELECT 0x00        ///< Page select register
 #define PCM51XX_REG_RESET 0x01              ///< Reset register
@@ -143,10 +249,463 @@ typedef enum {
 #define PCM51XX_REG_GPIO_INPUT 0x77         ///< GPIO input
 #define PCM51XX_REG_AUTO_MUTE_FLAG 0x78     ///< Auto mute flags
 
+/*! @brief Lowest allowed PLL output frequency */
+#define PCM51XX_PLL_MIN_HZ 64000000UL
+/*! @brief Highest allowed PLL output frequency */
+#define PCM51XX_PLL_MAX_HZ 100000000UL
+/*! @brief Highest allowed DSP clock frequency */
+#define PCM51XX_DSP_MAX_HZ 50000000UL
+/*! @brief Highest allowed DAC clock frequency */
+#define PCM51XX_DAC_MAX_HZ 6144000UL
+/*! @brief Target charge pump (NCP) clock frequency */
+#define PCM51XX_NCP_HZ 1536000UL
+
+/*! @brief Register address flag enabling I2C auto-increment bursts */
+#define PCM51XX_AUTO_INCREMENT 0x80
+
+/*! @brief Maximum number of distinct registers queued in one transaction */
+#define PCM51XX_TRANSACTION_SIZE 16
+
+/*! @brief Maximum number of DACs in an Adafruit_PCM51xx_Array */
+#define PCM51XX_ARRAY_MAX 4
+
+/*! @brief Maximum number of operations queued in an Adafruit_PCM51xx_Async */
+#define PCM51XX_ASYNC_QUEUE_SIZE 8
+
+/*! @brief Writes held by an Adafruit_PCM51xx_CommandQueue (power of 2) */
+#define PCM51XX_COMMAND_QUEUE_SIZE 16
+
+/*! @brief Number of page 1 registers mirrored by the shadow cache */
+#define PCM51XX_CACHE_PAGE1_REGS 16
+/*! @brief Shadow cache size: all of page 0 plus the low page 1 registers */
+#define PCM51XX_CACHE_SIZE (128 + PCM51XX_CACHE_PAGE1_REGS)
+
+/*! @brief DSP memory pages */
+#define PCM51XX_PAGE_CRAM_A 44  ///< First coefficient RAM page, buffer A
+#define PCM51XX_PAGE_CRAM_B 62  ///< First coefficient RAM page, buffer B
+#define PCM51XX_CRAM_PAGES 9    ///< Coefficient RAM pages per buffer
+#define PCM51XX_PAGE_IRAM 152   ///< First instruction RAM page
+#define PCM51XX_IRAM_PAGES 35   ///< Instruction RAM pages
+#define PCM51XX_DSP_FIRST_REG 8 ///< First DSP memory register on each page
+/*! @brief Page 44 coefficient buffer control (adaptive mode and swap) */
+#define PCM51XX_REG_CRAM_CTRL 0x01
+/*! @brief DSP program number running the program in instruction RAM */
+#define PCM51XX_DSP_PROGRAM_RAM 31
+
+/*! @brief Script meta commands, see loadDSPScript() */
+#define PCM51XX_SCRIPT_SWITCH 0xFF ///< Device switch (ignored)
+#define PCM51XX_SCRIPT_DELAY 0xFE  ///< Delay in milliseconds
+#define PCM51XX_SCRIPT_BURST 0xFD  ///< Burst of register + data bytes
+
+/*! @brief Bytes staged per bus transfer when loading from PROGMEM */
+#define PCM51XX_DSP_CHUNK 64
+
 /*! @brief Page 1 Register Addresses */
 #define PCM51XX_REG_PAGE1_OUTPUT_AMP_TYPE 0x01 ///< Output amplitude type (OSEL)
+#define PCM51XX_REG_PAGE1_ANALOG_GAIN 0x02     ///< Analog gain control
+#define PCM51XX_REG_PAGE1_UNDERVOLTAGE 0x05    ///< Undervoltage protection
+#define PCM51XX_REG_PAGE1_ANALOG_MUTE 0x06     ///< Analog mute control
+#define PCM51XX_REG_PAGE1_GAIN_BOOST 0x07      ///< Analog gain boost
+#define PCM51XX_REG_PAGE1_VCOM_RAMP 0x08       ///< VCOM ramp speed
 #define PCM51XX_REG_PAGE1_VCOM_POWER 0x09      ///< VCOM power control (VCPD)
 
+/*! @brief Number of registers in a configuration profile */
+#define PCM51XX_PROFILE_SIZE 53
+
+/*! @brief Register field flags */
+#define PCM51XX_FIELD_FLAG_VOLATILE 0x01  ///< Changed by the chip itself
+#define PCM51XX_FIELD_FLAG_READ_ONLY 0x02 ///< Ignores writes
+/*! @brief Flags of a read-only status field */
+#define PCM51XX_FIELD_FLAG_STATUS \
+  (PCM51XX_FIELD_FLAG_VOLATILE | PCM51XX_FIELD_FLAG_READ_ONLY)
+
+/*!
+ * @brief Location of a register bit field
+ *
+ * Fields are types, so every access compiles down to one masked register
+ * access with the page, address and mask as constants, and writes to
+ * read-only fields fail to compile.
+ */
+template <uint8_t PAGE, uint8_t REG, uint8_t WIDTH, uint8_t SHIFT,
+          uint8_t FLAGS = 0>
+struct pcm51xx_field {
+  static constexpr uint8_t page = PAGE;   ///< Register page
+  static constexpr uint8_t reg = REG;     ///< Register address
+  static constexpr uint8_t width = WIDTH; ///< Width of the field in bits
+  static constexpr uint8_t shift = SHIFT; ///< Position of the lowest bit
+  static constexpr uint8_t flags = FLAGS; ///< PCM51XX_FIELD_FLAG_* bits
+
+  /*! @brief Bits of the register covered by the field */
+  static constexpr uint8_t mask() {
+    return (uint8_t)(((1 << WIDTH) - 1) << SHIFT);
+  }
+  /*! @brief Field value from a raw register value */
+  static constexpr uint8_t get(uint8_t reg_value) {
+    return (uint8_t)((reg_value & mask()) >> SHIFT);
+  }
+  /*! @brief Field value shifted into place (other bits clear) */
+  static constexpr uint8_t place(uint8_t value) {
+    return (uint8_t)((value << SHIFT) & mask());
+  }
+};
+
+/*! @brief Register bit fields */
+typedef pcm51xx_field<0, PCM51XX_REG_RESET, 1, 4, PCM51XX_FIELD_FLAG_VOLATILE>
+    PCM51XX_FIELD_RESET_MODULES; ///< RSTM
+typedef pcm51xx_field<0, PCM51XX_REG_RESET, 1, 0, PCM51XX_FIELD_FLAG_VOLATILE>
+    PCM51XX_FIELD_RESET_REGISTERS; ///< RSTR
+typedef pcm51xx_field<0, PCM51XX_REG_STANDBY, 1, 4>
+    PCM51XX_FIELD_STANDBY; ///< Standby request (RQST)
+typedef pcm51xx_field<0, PCM51XX_REG_STANDBY, 1, 0>
+    PCM51XX_FIELD_POWERDOWN; ///< Powerdown request (RQPD)
+typedef pcm51xx_field<0, PCM51XX_REG_MUTE, 1, 4>
+    PCM51XX_FIELD_MUTE_LEFT; ///< Left channel mute (RQML)
+typedef pcm51xx_field<0, PCM51XX_REG_MUTE, 1, 0>
+    PCM51XX_FIELD_MUTE_RIGHT; ///< Right channel mute (RQMR)
+typedef pcm51xx_field<0, PCM51XX_REG_PLL, 1, 0>
+    PCM51XX_FIELD_PLL_ENABLE; ///< PLL enable (PLLE)
+typedef pcm51xx_field<0, PCM51XX_REG_PLL, 1, 4, PCM51XX_FIELD_FLAG_STATUS>
+    PCM51XX_FIELD_PLL_LOCK; ///< PLL lock flag (low when locked)
+typedef pcm51xx_field<0, PCM51XX_REG_DEEMPHASIS, 1, 4>
+    PCM51XX_FIELD_DEEMPHASIS; ///< De-emphasis enable (DEMP)
+typedef pcm51xx_field<0, PCM51XX_REG_GPIO_ENABLE, 6, 0>
+    PCM51XX_FIELD_GPIO_ENABLE; ///< GPIO output enables, bit n-1
+typedef pcm51xx_field<0, PCM51XX_REG_PLL_REF, 3, 4>
+    PCM51XX_FIELD_PLL_REF; ///< PLL reference (SREF)
+typedef pcm51xx_field<0, PCM51XX_REG_DAC_CLK_SRC, 3, 4>
+    PCM51XX_FIELD_DAC_CLK_SRC; ///< DAC clock source (SDAC)
+typedef pcm51xx_field<0, PCM51XX_REG_SYNC_REQ, 1, 0>
+    PCM51XX_FIELD_SYNC_REQ; ///< Clock divider sync request
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 6>
+    PCM51XX_FIELD_IGNORE_FS; ///< Ignore FS detection (IDFS)
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 5>
+    PCM51XX_FIELD_IGNORE_BCK; ///< Ignore BCK detection (IDBK)
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 4>
+    PCM51XX_FIELD_IGNORE_SCK; ///< Ignore SCK detection (IDSK)
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 3>
+    PCM51XX_FIELD_IGNORE_CLOCK_HALT; ///< Ignore clock halt (IDCH)
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 2>
+    PCM51XX_FIELD_IGNORE_CLOCK_MISSING; ///< Ignore missing clock (IDCM)
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 1>
+    PCM51XX_FIELD_DISABLE_AUTOSET; ///< Disable clock autoset (DCAS)
+typedef pcm51xx_field<0, PCM51XX_REG_ERROR_DETECT, 1, 0>
+    PCM51XX_FIELD_IGNORE_PLL_UNLOCK; ///< Ignore PLL unlock (IPLK)
+typedef pcm51xx_field<0, PCM51XX_REG_I2S_CONFIG, 2, 4>
+    PCM51XX_FIELD_I2S_FORMAT; ///< Audio interface format (AFMT)
+typedef pcm51xx_field<0, PCM51XX_REG_I2S_CONFIG, 2, 0>
+    PCM51XX_FIELD_I2S_SIZE; ///< Audio word length (ALEN)
+typedef pcm51xx_field<0, PCM51XX_REG_DSP_PROGRAM, 5, 0>
+    PCM51XX_FIELD_DSP_PROGRAM; ///< DSP program (PSEL)
+typedef pcm51xx_field<0, PCM51XX_REG_VOLUME_FADE_EMRG, 4, 4>
+    PCM51XX_FIELD_EMERGENCY_RAMP; ///< Emergency ramp rate/step
+typedef pcm51xx_field<0, PCM51XX_REG_AUTO_MUTE, 3, 0>
+    PCM51XX_FIELD_AUTO_MUTE; ///< Auto mute enables
+typedef pcm51xx_field<0, PCM51XX_REG_GPIO5_OUTPUT, 5, 0>
+    PCM51XX_FIELD_GPIO5_OUTPUT; ///< GPIO5 output selection
+typedef pcm51xx_field<0, PCM51XX_REG_GPIO_CONTROL, 6, 0>
+    PCM51XX_FIELD_GPIO_CONTROL; ///< GPIO register outputs, n-1
+typedef pcm51xx_field<0, PCM51XX_REG_POWER_STATE, 4, 0,
+                      PCM51XX_FIELD_FLAG_STATUS>
+    PCM51XX_FIELD_POWER_STATE; ///< Power state machine state
+typedef pcm51xx_field<0, PCM51XX_REG_POWER_STATE, 1, 7,
+                      PCM51XX_FIELD_FLAG_STATUS>
+    PCM51XX_FIELD_DSP_BOOT_DONE; ///< DSP boot finished
+typedef pcm51xx_field<0, PCM51XX_REG_GPIO_INPUT, 6, 0,
+                      PCM51XX_FIELD_FLAG_STATUS>
+    PCM51XX_FIELD_GPIO_INPUT; ///< GPIO input levels, bit n-1
+typedef pcm51xx_field<1, PCM51XX_REG_PAGE1_OUTPUT_AMP_TYPE, 1, 0>
+    PCM51XX_FIELD_OUTPUT_AMP_TYPE; ///< VCOM output (OSEL)
+typedef pcm51xx_field<1, PCM51XX_REG_PAGE1_VCOM_POWER, 1, 0>
+    PCM51XX_FIELD_VCOM_POWERDOWN; ///< VCOM powerdown (VCPD)
+typedef pcm51xx_field<PCM51XX_PAGE_CRAM_A, PCM51XX_REG_CRAM_CTRL, 1, 2>
+    PCM51XX_FIELD_CRAM_ADAPTIVE; ///< Adaptive coefficient buffers
+typedef pcm51xx_field<PCM51XX_PAGE_CRAM_A, PCM51XX_REG_CRAM_CTRL, 1, 1,
+                      PCM51XX_FIELD_FLAG_STATUS>
+    PCM51XX_FIELD_CRAM_ACTIVE_B; ///< DSP is running from buffer B
+typedef pcm51xx_field<PCM51XX_PAGE_CRAM_A, PCM51XX_REG_CRAM_CTRL, 1, 0,
+                      PCM51XX_FIELD_FLAG_VOLATILE>
+    PCM51XX_FIELD_CRAM_SWAP; ///< Buffer swap request
+
+/*! @brief PLL divider settings, fPLL = fREF * R * J.D / P */
+typedef struct {
+  uint8_t p;  ///< Pre-divider P (1-15)
+  uint8_t j;  ///< Integer part of the multiplier J (1-63)
+  uint16_t d; ///< Fractional part of the multiplier D (0-9999)
+  uint8_t r;  ///< Post-multiplier R (1-16)
+} pcm51xx_pll_t;
+
+/*!
+ * @brief Convert a volume in half-dB steps to a digital volume register value
+ * @param half_db Volume in 0.5dB steps (48 = 24dB, -207 = -103.5dB)
+ * @return Register value, clamped to the 0x00-0xFF range
+ */
+constexpr uint8_t pcm51xx_half_db_to_reg(int16_t half_db) {
+  return half_db >= 48 ? 0x00 : half_db <= -207 ? 0xFF : 48 - half_db;
+}
+
+/*!
+ * @brief Convert a digital volume register value to half-dB steps
+ * @param reg Register value (0x00 = 24dB, 0xFF = -103.5dB)
+ * @return Volume in 0.5dB steps
+ */
+constexpr int16_t pcm51xx_reg_to_half_db(uint8_t reg) {
+  return 48 - reg;
+}
+
+/*! @brief Complete clock tree settings, see planClocks() */
+typedef struct {
+  pcm51xx_dac_clk_src_t source; ///< DAC clock source
+  pcm51xx_pll_ref_t pll_ref;    ///< PLL reference (PLL source only)
+  pcm51xx_pll_t pll;            ///< PLL dividers (PLL source only)
+  uint32_t ref_hz;              ///< Source or PLL reference frequency
+  uint32_t master_hz;           ///< Clock feeding the dividers
+  uint32_t sample_rate;         ///< Sample rate in Hz
+  uint8_t dsp_div;              ///< DSP clock divider (1-128)
+  uint8_t dac_div;              ///< DAC clock divider (1-128)
+  uint8_t ncp_div;              ///< Charge pump clock divider (1-128)
+  uint8_t osr_div;              ///< Oversampling clock divider (1-128)
+  uint8_t fs_speed;             ///< FS speed mode (0-3)
+  uint16_t idac;                ///< DSP cycles per sample
+} pcm51xx_clock_plan_t;
+
+/*! @brief Clock error flags reported by getClockDetect() */
+#define PCM51XX_CLOCK_ERR_FS 0x01          ///< Sample rate invalid
+#define PCM51XX_CLOCK_ERR_BCK 0x02         ///< BCK invalid
+#define PCM51XX_CLOCK_ERR_SCK 0x04         ///< SCK invalid
+#define PCM51XX_CLOCK_ERR_SCK_RATIO 0x08   ///< SCK ratio invalid
+#define PCM51XX_CLOCK_ERR_BCK_MISSING 0x10 ///< BCK and LRCK missing
+#define PCM51XX_CLOCK_ERR_PLL_UNLOCK 0x20  ///< PLL not locked
+#define PCM51XX_CLOCK_ERR_SCK_MISSING 0x40 ///< SCK missing
+
+/*! @brief Clock detection readout, see getClockDetect() */
+typedef struct {
+  pcm51xx_fs_detect_t fs; ///< Detected sample rate range
+  uint16_t sck_ratio;     ///< Detected SCK/FS ratio (0 if invalid)
+  uint16_t bck_ratio;     ///< Detected BCK/FS ratio
+  uint8_t errors;         ///< PCM51XX_CLOCK_ERR_* flags
+  bool clock_halt;        ///< Latched clock halt flag
+} pcm51xx_clock_detect_t;
+
+/*! @brief Device status snapshot, see getStatus() */
+typedef struct {
+  pcm51xx_power_state_t power_state; ///< Current power state
+  pcm51xx_clock_detect_t clock;      ///< Clock detection results
+  bool pll_locked;                   ///< PLL locked
+  bool dsp_boot_done;                ///< DSP boot finished
+  bool muted;                        ///< Both channels soft muted
+  uint8_t dsp_overflow;              ///< DSP overflow flags
+  uint8_t analog_mute;               ///< Analog mute monitor flags
+  uint8_t gpio_input;                ///< GPIO input levels, bit n-1 = GPIOn
+  uint8_t auto_mute;                 ///< Auto mute flags
+} pcm51xx_status_t;
+
+/*! @brief Progress of the last non-blocking operation */
+typedef struct {
+  pcm51xx_op_t op;            ///< Operation
+  pcm51xx_op_status_t status; ///< Current progress
+  uint16_t polls;             ///< Status reads so far
+  uint32_t elapsed;           ///< Time since start in us (latency once done)
+} pcm51xx_op_info_t;
+
+/*!
+ * @brief Biquad coefficients in the DSP's 5.27 fixed-point format
+ *
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2], so the
+ * feedback coefficients are the negated cookbook a1 and a2.
+ */
+typedef struct {
+  int32_t b0; ///< Feed-forward coefficient b0
+  int32_t b1; ///< Feed-forward coefficient b1
+  int32_t b2; ///< Feed-forward coefficient b2
+  int32_t a1; ///< Feedback coefficient, -a1 / a0
+  int32_t a2; ///< Feedback coefficient, -a2 / a0
+} pcm51xx_biquad_t;
+
+/*!
+ * @brief Configuration profile: the writable page 0 and page 1 registers
+ *
+ * Values are stored in ascending page and register order, skipping the
+ * page select, reset, standby/powerdown and sync request registers. Make
+ * one with captureProfile(); it can be kept in PROGMEM.
+ */
+typedef struct {
+  uint8_t values[PCM51XX_PROFILE_SIZE]; ///< Register values
+} pcm51xx_profile_t;
+
+/*! @brief Result of the last DSP memory load or verification */
+typedef struct {
+  uint32_t bytes; ///< DSP memory bytes transferred
+  uint32_t time;  ///< Duration in us
+  uint16_t crc;   ///< CRC-16/CCITT of the DSP memory bytes
+  bool verified;  ///< Readback CRC matched (verification only)
+} pcm51xx_dsp_load_t;
+
+/*! @brief Bus traffic counters */
+typedef struct {
+  uint32_t transactions;  ///< Addressed bus transfers, page selects included
+  uint32_t reads;         ///< Transfers that read data back
+  uint32_t page_selects;  ///< Page select writes
+  uint32_t bytes_written; ///< Register address and data bytes sent
+  uint32_t bytes_read;    ///< Data bytes received
+} pcm51xx_bus_stats_t;
+
+/*! @brief Last error reported by getLastError() */
+typedef enum {
+  PCM51XX_ERROR_NONE = 0, ///< No error
+  PCM51XX_ERROR_BUS = 1,  ///< A bus transfer failed after every retry
+  PCM51XX_ERROR_RESET = 2 ///< The chip had reset and lost its configuration
+} pcm51xx_error_t;
+
+/*! @brief Bus error and recovery counters */
+typedef struct {
+  uint32_t errors;   ///< Failed transfer attempts
+  uint32_t retries;  ///< Transfers attempted again after a failure
+  uint32_t failures; ///< Transfers that failed after every retry
+  uint16_t resets;   ///< Chip resets detected
+  uint16_t restores; ///< Configurations reapplied after a reset
+} pcm51xx_error_stats_t;
+
+/*! @brief Public calls timed by the instrumentation (PCM51XX_INSTRUMENT) */
+typedef enum {
+  PCM51XX_API_BEGIN = 0,         ///< begin()
+  PCM51XX_API_SET_VOLUME = 1,    ///< setVolumeDB() and the half-dB setters
+  PCM51XX_API_GET_VOLUME = 2,    ///< getVolumeDB(), getVolumeHalfDB()
+  PCM51XX_API_MUTE = 3,          ///< mute()
+  PCM51XX_API_FADE = 4,          ///< updateFade()
+  PCM51XX_API_POLL = 5,          ///< pollOperation()
+  PCM51XX_API_STATUS = 6,        ///< getStatus()
+  PCM51XX_API_CLOCK_PLAN = 7,    ///< applyClockPlan()
+  PCM51XX_API_SWITCH_RATE = 8,   ///< switchSampleRate()
+  PCM51XX_API_DSP_LOAD = 9,      ///< writeDSPMemory(), loadDSPScript()
+  PCM51XX_API_COEFFICIENTS = 10, ///< updateCoefficients()
+  PCM51XX_API_PROFILE = 11,      ///< applyProfile()
+  PCM51XX_API_COMMIT = 12,       ///< commit(), endTransaction()
+  PCM51XX_API_READ = 13,         ///< readRegisters(), used by every getter
+  PCM51XX_API_WRITE = 14         ///< writeRegisters(), used by every setter
+} pcm51xx_api_t;
+
+/*! @brief Number of pcm51xx_api_t entries */
+#define PCM51XX_API_COUNT 15
+
+/*!
+ * @brief Number of latency histogram buckets
+ *
+ * Bucket 0 counts calls under 16us and each following bucket covers a range
+ * four times longer (under 64us, 256us, ...); the last one is open-ended.
+ */
+#define PCM51XX_HIST_BUCKETS 8
+
+/*! @brief Call count and latency of one public call */
+typedef struct {
+  uint32_t calls;                           ///< Number of calls
+  uint32_t total_us;                        ///< Time spent in all calls
+  uint32_t max_us;                          ///< Slowest call
+  uint16_t histogram[PCM51XX_HIST_BUCKETS]; ///< Calls by duration
+} pcm51xx_api_stats_t;
+
+/*! @brief Instrumentation snapshot, see getInstrumentation() */
+typedef struct {
+  pcm51xx_bus_stats_t bus;       ///< Bus traffic, incl. page selects made
+  pcm51xx_error_stats_t errors;  ///< Bus errors and recoveries
+  uint32_t pages_avoided;        ///< Page selects skipped, already on page
+  uint16_t reg_transfers[128];   ///< Transfers touching each page 0 register
+  uint16_t other_page_transfers; ///< Transfers on any other page
+  /*! @brief Per call statistics, indexed by pcm51xx_api_t */
+  pcm51xx_api_stats_t api[PCM51XX_API_COUNT];
+} pcm51xx_instrument_t;
+
+#ifndef PCM51XX_TRACE_SIZE
+/*! @brief Register accesses kept by the trace ring buffer (PCM51XX_TRACE) */
+#define PCM51XX_TRACE_SIZE 128
+#endif
+
+/*!
+ * @brief Bytes per trace record
+ *
+ * Each register access is one record: the register address with
+ * PCM51XX_TRACE_WRITE set for writes, the value, then a little-endian 16-bit
+ * word holding the microseconds since the previous record (saturating at
+ * PCM51XX_TRACE_MAX_DELTA) and PCM51XX_TRACE_FAILED. Bursts give one record
+ * per register. Pages are not stored: they follow from the page select
+ * (register 0) writes in the trace.
+ */
+#define PCM51XX_TRACE_RECORD 4
+#define PCM51XX_TRACE_WRITE 0x80       ///< Record flag: register was written
+#define PCM51XX_TRACE_FAILED 0x8000    ///< Record flag: transfer failed
+#define PCM51XX_TRACE_MAX_DELTA 0x7FFF ///< Largest time step in a record
+
+/*! @brief A single (possibly partial) register write */
+typedef struct {
+  uint8_t page;  ///< Register page
+  uint8_t reg;   ///< Register address
+  uint8_t mask;  ///< Bits to change (0xFF for a full register write)
+  uint8_t value; ///< New value for the masked bits
+} pcm51xx_reg_write_t;
+
+/*! @brief State of a transfer started on an Adafruit_PCM51xx_Transport */
+typedef enum {
+  PCM51XX_TRANSFER_BUSY = 0, ///< Transfer still running
+  PCM51XX_TRANSFER_DONE = 1, ///< Transfer finished successfully
+  PCM51XX_TRANSFER_ERROR = 2 ///< Transfer failed
+} pcm51xx_transfer_t;
+
+/*!
+ * @brief Completion callback of a queued register operation
+ * @param ok True if the operation succeeded
+ * @param value Register value written or read
+ * @param arg Argument given when the operation was queued
+ */
+typedef void (*pcm51xx_async_callback_t)(bool ok, uint8_t value, void* arg);
+
+/*! @brief A register operation waiting in an Adafruit_PCM51xx_Async queue */
+typedef struct {
+  uint8_t page;                      ///< Register page
+  uint8_t reg;                       ///< Register address
+  uint8_t value;                     ///< Value to write, or value read
+  bool read;                         ///< True for a read, false for a write
+  uint8_t* dest;                     ///< Where to store a read, or nullptr
+  pcm51xx_async_callback_t callback; ///< Completion callback, or nullptr
+  void* arg;                         ///< Callback argument
+} pcm51xx_async_op_t;
+
+/*! @brief Asynchronous queue counters */
+typedef struct {
+  uint32_t queued;     ///< Operations accepted
+  uint32_t completed;  ///< Operations finished successfully
+  uint32_t failed;     ///< Operations that failed
+  uint32_t transfers;  ///< Transfers started, page selects included
+  uint32_t blocked_us; ///< Time spent inside transport calls
+  uint8_t max_depth;   ///< Deepest the queue has been
+} pcm51xx_async_stats_t;
+
+/*!
+ * @brief  Batch of pending register writes
+ *
+ * Writes are kept sorted by page and address, and writes to the same
+ * register are merged, so committing the batch needs at most one page
+ * switch per page and one auto-increment burst per run of contiguous
+ * registers.
+ */
+class Adafruit_PCM51xx_Transaction {
+ public:
+  Adafruit_PCM51xx_Transaction(void);
+
+  void clear(void);
+  uint8_t count(void);
+
+  bool write(uint8_t page, uint8_t reg, uint8_t value);
+  bool update(uint8_t page, uint8_t reg, uint8_t mask, uint8_t value);
+  bool writeBits(uint8_t page, uint8_t reg, uint8_t bits, uint8_t shift,
+                 uint8_t value);
+  template <class FIELD>
+  bool writeField(uint8_t value);
+
+ private:
+  friend class Adafruit_PCM51xx;
+  pcm51xx_reg_write_t _writes[PCM51XX_TRANSACTION_SIZE]; ///< Queued writes
+  uint8_t _count;                                        ///< Queue length
+};
+
 /*!
  * @brief  PCM51xx class
  */
@@ -155,13 +714,48 @@ class Adafruit_PCM51xx {
   Adafruit_PCM51xx(void);
   ~Adafruit_PCM51xx(void);
 
+#ifndef PCM51XX_SPI_ONLY
   bool begin(uint8_t i2c_addr = PCM51XX_DEFAULT_ADDR, TwoWire* wire = &Wire);
+#endif
+#ifndef PCM51XX_I2C_ONLY
   bool begin(int8_t cs_pin, SPIClass* theSPI);
   bool begin(int8_t cs_pin, int8_t mosi_pin, int8_t miso_pin, int8_t sclk_pin);
+#endif
 
   bool resetModules(void);
   bool resetRegisters(void);
 
+  bool startOperation(pcm51xx_op_t op, uint16_t timeout_ms = 200);
+  pcm51xx_op_status_t pollOperation(void);
+  pcm51xx_op_info_t getOperation(void);
+
+  uint32_t getBootTime(void);
+  uint32_t getBootTransactions(void);
+
+  pcm51xx_bus_stats_t getBusStats(void);
+  void resetBusStats(void);
+
+  void setRetryPolicy(uint8_t retries, uint16_t backoff_us = 100);
+  void enableAutoRecover(bool enable);
+  bool checkReset(void);
+  bool restoreConfiguration(void);
+  pcm51xx_error_t getLastError(void);
+  pcm51xx_error_stats_t getErrorStats(void);
+  void resetErrorStats(void);
+
+#ifdef PCM51XX_INSTRUMENT
+  void getInstrumentation(pcm51xx_instrument_t* snapshot);
+  void resetInstrumentation(void);
+  void dumpInstrumentation(Print* out);
+#endif
+
+#ifdef PCM51XX_TRACE
+  void enableTrace(bool enable);
+  void clearTrace(void);
+  uint16_t getTraceCount(void);
+  void dumpTrace(Print* out);
+#endif
+
   bool standby(bool enable);
   bool isStandby(void);
   bool powerdown(bool enable);
@@ -177,6 +771,20 @@ class Adafruit_PCM51xx {
 
   bool setVolumeDB(float leftDB, float rightDB);
   void getVolumeDB(float* leftDB, float* rightDB);
+  bool setVolumeHalfDB(int16_t left, int16_t right);
+  bool setLeftVolumeHalfDB(int16_t left);
+  bool setRightVolumeHalfDB(int16_t right);
+  bool getVolumeHalfDB(int16_t* left, int16_t* right);
+  bool setVolumeRamp(pcm51xx_ramp_rate_t down_rate,
+                     pcm51xx_ramp_step_t down_step,
+                     pcm51xx_ramp_rate_t up_rate, pcm51xx_ramp_step_t up_step);
+  bool setEmergencyRamp(pcm51xx_ramp_rate_t rate, pcm51xx_ramp_step_t step);
+  bool startFade(float leftDB, float rightDB, uint16_t duration_ms,
+                 pcm51xx_fade_curve_t curve = PCM51XX_FADE_LINEAR);
+  bool updateFade(void);
+  bool isFading(void);
+  void stopFade(void);
+  void setFadeStepInterval(uint16_t min_us);
 
   bool getDSPBootDone(void);
   pcm51xx_power_state_t getPowerState(void);
@@ -216,13 +824,457 @@ class Adafruit_PCM51xx {
   pcm51xx_gpio5_output_t getGPIO5Output(void);
   bool setGPIODirection(uint8_t gpio, bool output);
   bool setGPIORegisterOutput(uint8_t gpio, bool high);
+  bool setGPIOOutput(uint8_t gpio, pcm51xx_gpio5_output_t output);
+
+  bool routeEvent(pcm51xx_event_t event, uint8_t gpio);
+  bool onEvent(pcm51xx_event_t event, pcm51xx_event_callback_t callback);
+  bool attachEventPin(uint8_t pin);
+  void detachEventPins(void);
+  uint8_t handleEvents(void);
+  uint8_t getActiveEvents(void);
+
+  static bool findPLLDividers(uint32_t ref_hz, uint32_t pll_hz,
+                              pcm51xx_pll_t* pll);
+  bool setPLLDividers(const pcm51xx_pll_t* pll);
+  bool getPLLDividers(pcm51xx_pll_t* pll);
+  bool configurePLL(pcm51xx_pll_ref_t ref, uint32_t ref_hz,
+                    uint32_t sample_rate);
+
+  static bool planClocks(pcm51xx_dac_clk_src_t source,
+                         pcm51xx_pll_ref_t pll_ref, uint32_t ref_hz,
+                         uint32_t sample_rate, pcm51xx_i2s_size_t size,
+                         pcm51xx_clock_plan_t* plan);
+  static bool validateClockPlan(const pcm51xx_clock_plan_t* plan);
+  bool applyClockPlan(const pcm51xx_clock_plan_t* plan);
+  bool getClockPlan(pcm51xx_clock_plan_t* plan);
+  bool switchSampleRate(uint32_t sample_rate);
+  bool switchSampleRate(const pcm51xx_clock_plan_t* plan);
+  uint32_t getSwitchTime(void);
+  bool getClockDetect(pcm51xx_clock_detect_t* detect);
+  bool getStatus(pcm51xx_status_t* status);
+
+  bool setDSPProgram(uint8_t program);
+  uint8_t getDSPProgram(void);
+  bool writeDSPMemory(uint8_t page, uint8_t reg, const uint8_t* data,
+                      uint16_t len, bool progmem = false);
+  bool verifyDSPMemory(uint8_t page, uint8_t reg, const uint8_t* data,
+                       uint16_t len, bool progmem = false);
+  bool loadDSPScript(const uint8_t* script, uint16_t len, bool progmem = false,
+                     bool verify = false);
+  bool setAdaptiveMode(bool enable);
+  bool updateCoefficients(uint16_t offset, const uint8_t* data, uint16_t len,
+                          bool progmem = false);
+  bool readCoefficients(uint16_t offset, uint8_t* data, uint16_t len);
+  pcm51xx_dsp_load_t getDSPLoadInfo(void);
+
+  static bool designBiquad(pcm51xx_biquad_type_t type, float freq, float q,
+                           float gain_db, uint32_t sample_rate,
+                           pcm51xx_biquad_t* biquad);
+  bool setBiquad(uint16_t offset, const pcm51xx_biquad_t* biquad);
+  bool setBiquad(uint16_t offset, pcm51xx_biquad_type_t type, float freq,
+                 float q, float gain_db);
+
+  bool captureProfile(pcm51xx_profile_t* profile);
+  bool applyProfile(const pcm51xx_profile_t* profile, bool progmem = false);
+  static uint8_t diffProfiles(const pcm51xx_profile_t* from,
+                              const pcm51xx_profile_t* to,
+                              pcm51xx_reg_write_t* diffs, uint8_t max_diffs);
+
+  void setLock(pcm51xx_lock_fn_t lock, pcm51xx_lock_fn_t unlock,
+               void* arg = nullptr);
+
+  void enableCache(bool enable);
+  bool isCacheEnabled(void);
+  void invalidateCache(void);
+
+  void beginTransaction(Adafruit_PCM51xx_Transaction* txn);
+  bool endTransaction(void);
+  bool commit(Adafruit_PCM51xx_Transaction* txn);
+
+  bool readRegisters(uint8_t page, uint8_t reg, uint8_t* buffer, uint8_t len);
+  bool writeRegisters(uint8_t page, uint8_t reg, const uint8_t* buffer,
+                      uint8_t len);
 
  private:
+  friend class Adafruit_PCM51xx_Array;
+  friend class Adafruit_PCM51xx_Async;
+  friend class Adafruit_PCM51xx_BusTransport;
   bool selectPage(uint8_t page);
+  bool busRead(uint8_t addr, uint8_t* buffer, uint8_t len);
+  bool busWrite(uint8_t addr, const uint8_t* buffer, uint8_t len);
+  bool rawRead(uint8_t addr, uint8_t* buffer, uint8_t len);
+  bool rawWrite(uint8_t addr, const uint8_t* buffer, uint8_t len);
+  bool restorePage(uint8_t page);
+  bool handleBusError(uint8_t attempt);
+  void recoverIfNeeded(void);
+  void noteWrite(uint8_t page, uint8_t reg, uint8_t value, bool ok);
+#ifdef PCM51XX_INSTRUMENT
+  void countTransfer(uint8_t addr, uint8_t len);
+#endif
+#ifdef PCM51XX_TRACE
+  void traceTransfer(uint8_t addr, const uint8_t* buffer, uint8_t len,
+                     bool write, bool ok);
+#endif
   bool _init(void);
-  Adafruit_I2CDevice* i2c_dev; ///< Pointer to I2C bus interface
-  Adafruit_SPIDevice* spi_dev; ///< Pointer to SPI bus interface
-  uint8_t _page;               ///< Current selected page (cached)
+  static bool planPLL(uint32_t ref_hz, uint32_t sample_rate,
+                      pcm51xx_pll_t* pll);
+  bool waitForClear(uint8_t page, uint8_t reg, uint8_t mask);
+  static bool isVolatileRegister(uint8_t page, uint8_t reg);
+  bool transferDSPMemory(uint8_t page, uint8_t reg, const uint8_t* data,
+                         uint16_t len, bool progmem, bool verify,
+                         uint16_t* crc, uint16_t* check);
+  bool dspSegment(uint8_t page, uint8_t reg, const uint8_t* data, uint8_t len,
+                  bool progmem, bool verify, uint16_t* crc, uint16_t* check);
+  bool runDSPScript(const uint8_t* script, uint16_t len, bool progmem,
+                    bool verify, uint16_t* crc, uint16_t* check);
+  bool send(const Adafruit_PCM51xx_Transaction* txn);
+  template <uint8_t SLOT>
+  static void eventISR(void);
+  void releaseBus(void);
+  uint8_t maxTransfer(void);
+  int16_t cacheSlot(uint8_t page, uint8_t reg);
+  bool peekCache(uint8_t page, uint8_t reg, uint8_t* value);
+  void storeCache(uint8_t page, uint8_t reg, uint8_t value);
+  void dropCache(uint8_t page, uint8_t reg);
+  bool readRegister(uint8_t page, uint8_t reg, uint8_t* value);
+  bool writeRegister(uint8_t page, uint8_t reg, uint8_t value);
+  bool updateRegister(uint8_t page, uint8_t reg, uint8_t mask, uint8_t value);
+  template <class FIELD>
+  bool readField(uint8_t* value);
+  template <class FIELD>
+  bool writeField(uint8_t value);
+  template <class FIELD>
+  bool writeFieldBit(uint8_t bit, bool set);
+#ifndef PCM51XX_SPI_ONLY
+  Adafruit_I2CDevice* i2c_dev; ///< I2C bus interface (in _bus), or nullptr
+#endif
+#ifndef PCM51XX_I2C_ONLY
+  Adafruit_SPIDevice* spi_dev; ///< SPI bus interface (in _bus), or nullptr
+#endif
+  /*! @brief In-place storage for the bus device, so begin() needs no heap */
+  union BusStorage {
+    BusStorage(void) {}
+    ~BusStorage(void) {}
+#ifndef PCM51XX_SPI_ONLY
+    Adafruit_I2CDevice i2c; ///< I2C device
+#endif
+#ifndef PCM51XX_I2C_ONLY
+    Adafruit_SPIDevice spi; ///< SPI device
+#endif
+  } _bus; ///< Bus device storage
+  /*! @brief Holds the lock set with setLock() while in scope */
+  struct BusLock {
+    BusLock(Adafruit_PCM51xx* dac);
+    ~BusLock(void);
+    Adafruit_PCM51xx* _dac; ///< DAC whose lock is held
+  };
+  pcm51xx_lock_fn_t _lock;   ///< Lock hook, or nullptr
+  pcm51xx_lock_fn_t _unlock; ///< Unlock hook, or nullptr
+  void* _lock_arg;           ///< Argument for the lock hooks
+
+  uint8_t _retries;                   ///< Extra attempts per failed transfer
+  uint16_t _retry_backoff;            ///< First wait before a retry in us
+  bool _auto_recover;                 ///< Check for a reset after errors
+  bool _reset_check;                  ///< A bus error happened since check
+  bool _recovering;                   ///< Reset check or restore running
+  uint8_t _error_detect;              ///< Last 0x25 write, 0 if unknown
+  pcm51xx_error_t _last_error;        ///< Error for getLastError()
+  pcm51xx_error_stats_t _error_stats; ///< Error and recovery counters
+
+#ifdef PCM51XX_INSTRUMENT
+  /*! @brief Times a public call into its latency histogram */
+  struct ApiTimer {
+    ApiTimer(Adafruit_PCM51xx* dac, pcm51xx_api_t api);
+    ~ApiTimer(void);
+    Adafruit_PCM51xx* _dac; ///< DAC the call was made on
+    pcm51xx_api_t _api;     ///< Call being timed
+    uint32_t _start;        ///< Call start time in us
+  };
+  pcm51xx_instrument_t _instrument; ///< Counters (bus and errors unused)
+#endif
+#ifdef PCM51XX_TRACE
+  /*! @brief Trace ring buffer, see PCM51XX_TRACE_RECORD */
+  uint8_t _trace[PCM51XX_TRACE_SIZE * PCM51XX_TRACE_RECORD];
+  uint16_t _trace_head;    ///< Next record slot
+  uint16_t _trace_count;   ///< Records held
+  uint32_t _trace_dropped; ///< Records overwritten since clearTrace()
+  uint32_t _trace_time;    ///< micros() of the newest record
+  uint8_t _trace_page;     ///< Page before the oldest record, 0xFF unknown
+  bool _trace_enabled;     ///< Recording register accesses
+#endif
+  uint8_t _page;                      ///< Current selected page (cached)
+  Adafruit_PCM51xx_Transaction* _txn; ///< Transaction collecting writes
+
+  pcm51xx_bus_stats_t _bus_stats; ///< Bus traffic counters
+  uint32_t _boot_time;            ///< Duration of the last begin() in us
+  uint32_t _boot_transactions;    ///< Transactions used by the last begin()
+
+  pcm51xx_op_info_t _op; ///< Non-blocking operation progress
+  uint32_t _op_start;    ///< Operation start time in us
+  uint32_t _op_timeout;  ///< Operation timeout in us
+  uint32_t _op_last;     ///< Time of the last status read in us
+  uint16_t _op_wait;     ///< Current wait between status reads in us
+
+  bool _fading;                     ///< Software fade in progress
+  pcm51xx_fade_curve_t _fade_curve; ///< Software fade curve
+  uint8_t _fade_from[2];            ///< Fade start volume registers
+  uint8_t _fade_to[2];              ///< Fade target volume registers
+  uint8_t _fade_last[2];            ///< Volume registers last written
+  uint32_t _fade_start;             ///< Fade start time in us
+  uint32_t _fade_duration;          ///< Fade duration in us
+  uint32_t _fade_interval;          ///< Time between fade steps in us
+  uint32_t _fade_last_step;         ///< Time of the last fade step in us
+  uint16_t _fade_min_interval;      ///< Shortest time between steps in us
+
+  pcm51xx_dsp_load_t _dsp_load; ///< Last DSP memory load result
+
+  pcm51xx_clock_plan_t _clock_plan; ///< Clock tree currently programmed
+  bool _clock_plan_valid;           ///< _clock_plan matches the chip
+  uint32_t _switch_time;            ///< Duration of the last rate switch in us
+
+  uint8_t _event_gpio[PCM51XX_EVENT_COUNT]; ///< DAC GPIO per event, 0 if none
+  pcm51xx_event_callback_t
+      _event_callbacks[PCM51XX_EVENT_COUNT]; ///< Callback per event
+  uint8_t _event_active;                     ///< Active events, bit n
+  volatile bool _event_pending; ///< A flag pin changed since handleEvents()
+  static Adafruit_PCM51xx*
+      _event_owners[PCM51XX_EVENT_PINS];          ///< Instance per ISR slot
+  static uint8_t _event_pins[PCM51XX_EVENT_PINS]; ///< MCU pin per ISR slot
+
+#ifndef PCM51XX_NO_CACHE
+  bool _cache_enabled;                                ///< Shadow cache in use
+  uint8_t _cache[PCM51XX_CACHE_SIZE];                 ///< Shadow register copy
+  uint8_t _cache_valid[(PCM51XX_CACHE_SIZE + 7) / 8]; ///< Valid slot bitmap
+#endif
+};
+
+/*!
+ * @brief  Controller applying one configuration to several PCM51xx chips
+ *
+ * Shared settings are batched once into a transaction and the same
+ * bursts are sent to every DAC. Clock changes hold all chips in sync
+ * request until every one is reprogrammed, then release them back to
+ * back so their clock dividers restart together.
+ */
+class Adafruit_PCM51xx_Array {
+ public:
+  Adafruit_PCM51xx_Array(void);
+
+  bool add(Adafruit_PCM51xx* dac);
+  uint8_t count(void);
+  Adafruit_PCM51xx* device(uint8_t index);
+  uint8_t getFailed(void);
+
+  bool apply(Adafruit_PCM51xx_Transaction* txn);
+  bool applyClockPlan(const pcm51xx_clock_plan_t* plan);
+  bool resync(void);
+  bool setVolumeMap(const int16_t* half_db, int16_t offset = 0);
+  bool mute(bool enable);
+
+ private:
+  bool holdSync(bool hold);
+  Adafruit_PCM51xx* _dacs[PCM51XX_ARRAY_MAX]; ///< DACs in channel order
+  uint8_t _count;                             ///< Number of DACs
+  uint8_t _failed;                            ///< DACs that failed, bit n
 };
 
+/*!
+ * @brief  Lock-free queue of register writes from one producer task
+ *
+ * Give each task that changes the DAC its own queue. The task posts writes
+ * without touching the bus, and the one task that owns the DAC applies
+ * them with drain(), so page selection and read-modify-writes are never
+ * interleaved between tasks. Writes drained together are applied as one
+ * transaction: in register order, with writes to the same register merged.
+ */
+class Adafruit_PCM51xx_CommandQueue {
+ public:
+  Adafruit_PCM51xx_CommandQueue(void);
+
+  bool post(uint8_t page, uint8_t reg, uint8_t mask, uint8_t value);
+  template <class FIELD>
+  bool postField(uint8_t value);
+  bool drain(Adafruit_PCM51xx* dac);
+  uint8_t pending(void);
+  uint32_t getDropped(void);
+
+ private:
+  pcm51xx_reg_write_t _writes[PCM51XX_COMMAND_QUEUE_SIZE]; ///< Ring buffer
+  uint8_t _head;     ///< Next slot to post to, written by the producer only
+  uint8_t _tail;     ///< Next slot to drain, written by the consumer only
+  uint32_t _dropped; ///< Writes rejected because the queue was full
+};
+
+/*!
+ * @brief  Bus interface used by Adafruit_PCM51xx_Async
+ *
+ * Subclass this to move register transfers onto DMA or an interrupt-driven
+ * bus driver. A transfer addresses the chip's current page; only one runs
+ * at a time and its buffer stays valid until poll() reports the end.
+ */
+class Adafruit_PCM51xx_Transport {
+ public:
+  /*! @brief Destructor */
+  virtual ~Adafruit_PCM51xx_Transport(void) {}
+
+  /*!
+   * @brief Start writing consecutive registers
+   * @param reg First register address
+   * @param buffer Data to write
+   * @param len Number of bytes
+   * @return True if the transfer was started, false otherwise
+   */
+  virtual bool startWrite(uint8_t reg, const uint8_t* buffer, uint8_t len) = 0;
+
+  /*!
+   * @brief Start reading consecutive registers
+   * @param reg First register address
+   * @param buffer Buffer to store the data
+   * @param len Number of bytes
+   * @return True if the transfer was started, false otherwise
+   */
+  virtual bool startRead(uint8_t reg, uint8_t* buffer, uint8_t len) = 0;
+
+  /*!
+   * @brief Check on the transfer last started
+   * @return PCM51XX_TRANSFER_BUSY until it ends, then its result
+   */
+  virtual pcm51xx_transfer_t poll(void) = 0;
+};
+
+/*!
+ * @brief  Default transport: the DAC's own I2C or SPI device
+ *
+ * Adafruit_BusIO transfers block, so each transfer is complete when its
+ * start call returns. Traffic is counted in the DAC's bus stats.
+ */
+class Adafruit_PCM51xx_BusTransport : public Adafruit_PCM51xx_Transport {
+ public:
+  Adafruit_PCM51xx_BusTransport(Adafruit_PCM51xx* dac);
+
+  bool startWrite(uint8_t reg, const uint8_t* buffer, uint8_t len);
+  bool startRead(uint8_t reg, uint8_t* buffer, uint8_t len);
+  pcm51xx_transfer_t poll(void);
+
+ private:
+  Adafruit_PCM51xx* _dac;     ///< DAC whose bus device is used
+  pcm51xx_transfer_t _result; ///< Result of the last transfer
+};
+
+/*!
+ * @brief  Queue of register operations completed in the background
+ *
+ * Operations are queued without touching the bus and carried out one
+ * transfer at a time by poll(), which never waits for the bus itself.
+ * Keep calling poll() from loop() (or a task); reads of cached registers
+ * complete without any transfer. Do not use the DAC's blocking API while
+ * operations are pending. A queued register reset drops the DAC's shadow
+ * cache and clock plan once it completes, as a blocking one does.
+ */
+class Adafruit_PCM51xx_Async {
+ public:
+  Adafruit_PCM51xx_Async(Adafruit_PCM51xx* dac,
+                         Adafruit_PCM51xx_Transport* transport = nullptr);
+
+  bool write(uint8_t page, uint8_t reg, uint8_t value,
+             pcm51xx_async_callback_t callback = nullptr,
+             void* arg = nullptr);
+  bool read(uint8_t page, uint8_t reg, uint8_t* value,
+            pcm51xx_async_callback_t callback = nullptr,
+            void* arg = nullptr);
+  bool poll(void);
+  bool flush(uint32_t timeout_ms = 100);
+  uint8_t pending(void);
+
+  pcm51xx_async_stats_t getStats(void);
+  void resetStats(void);
+
+ private:
+  bool push(const pcm51xx_async_op_t* op);
+  bool start(void);
+  void finish(bool ok);
+  Adafruit_PCM51xx* _dac;                            ///< DAC being driven
+  Adafruit_PCM51xx_BusTransport _bus;                ///< Default transport
+  Adafruit_PCM51xx_Transport* _transport;            ///< Transport in use
+  pcm51xx_async_op_t _ops[PCM51XX_ASYNC_QUEUE_SIZE]; ///< Ring buffer
+  uint8_t _head;                                     ///< Oldest operation
+  uint8_t _count;                                    ///< Operations queued
+  bool _busy;                                        ///< Transfer in flight
+  bool _paging;                                      ///< Page select in flight
+  uint8_t _page;                                     ///< Page select value
+  pcm51xx_async_stats_t _stats;                      ///< Counters
+};
+
+/*!
+ * @brief Queue a write of a register bit field
+ * @tparam FIELD Field to write (one of the PCM51XX_FIELD_* types)
+ * @param value New field value
+ * @return True if queued, false if the transaction is full
+ */
+template <class FIELD>
+bool Adafruit_PCM51xx_Transaction::writeField(uint8_t value) {
+  static_assert(!(FIELD::flags & PCM51XX_FIELD_FLAG_READ_ONLY),
+                "read-only register field");
+  return update(FIELD::page, FIELD::reg, FIELD::mask(), FIELD::place(value));
+}
+
+/*!
+ * @brief Post a write of a register bit field
+ * @tparam FIELD Field to write (one of the PCM51XX_FIELD_* types)
+ * @param value New field value
+ * @return True if posted, false if the queue is full
+ */
+template <class FIELD>
+bool Adafruit_PCM51xx_CommandQueue::postField(uint8_t value) {
+  static_assert(!(FIELD::flags & PCM51XX_FIELD_FLAG_READ_ONLY),
+                "read-only register field");
+  return post(FIELD::page, FIELD::reg, FIELD::mask(), FIELD::place(value));
+}
+
+/*!
+ * @brief Read a register bit field
+ * @tparam FIELD Field to read (one of the PCM51XX_FIELD_* types)
+ * @param value Pointer to store the field value
+ * @return True if successful, false otherwise
+ */
+template <class FIELD>
+bool Adafruit_PCM51xx::readField(uint8_t* value) {
+  uint8_t data;
+  if (!readRegister(FIELD::page, FIELD::reg, &data)) {
+    return false;
+  }
+
+  *value = FIELD::get(data);
+  return true;
+}
+
+/*!
+ * @brief Write a register bit field
+ * @tparam FIELD Field to write (one of the PCM51XX_FIELD_* types)
+ * @param value New field value
+ * @return True if successful, false otherwise
+ */
+template <class FIELD>
+bool Adafruit_PCM51xx::writeField(uint8_t value) {
+  static_assert(!(FIELD::flags & PCM51XX_FIELD_FLAG_READ_ONLY),
+                "read-only register field");
+  return updateRegister(FIELD::page, FIELD::reg, FIELD::mask(),
+                        FIELD::place(value));
+}
+
+/*!
+ * @brief Write a single bit of a per-pin register field
+ * @tparam FIELD Field holding one bit per pin
+ * @param bit Bit within the field
+ * @param set True to set the bit, false to clear it
+ * @return True if successful, false otherwise
+ */
+template <class FIELD>
+bool Adafruit_PCM51xx::writeFieldBit(uint8_t bit, bool set) {
+  static_assert(!(FIELD::flags & PCM51XX_FIELD_FLAG_READ_ONLY),
+                "read-only register field");
+  uint8_t mask = FIELD::place(1 << bit);
+  return updateRegister(FIELD::page, FIELD::reg, mask, set ? mask : 0);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*!
+ * @file async_queue.ino
+ *
+ * Asynchronous register queue example for the Adafruit PCM51xx library
+ *
+ * Queues volume writes and a power state read without waiting for the
+ * bus, lets loop() carry them out one transfer at a time, and prints the
+ * queue throughput and the CPU time spent blocked in bus transfers once a
+ * second. Pass your own Adafruit_PCM51xx_Transport to the queue to move
+ * the transfers onto DMA.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+Adafruit_PCM51xx_Async queue(&pcm);
+
+uint8_t volume = 0x30;
+uint32_t last_report = 0;
+
+void onPowerState(bool ok, uint8_t value, void* arg) {
+  (void)arg;
+  if (ok) {
+    Serial.print(F("Power state: "));
+    Serial.println(value & 0x0F);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Async Queue Test"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+  pcm.enableCache(true);
+}
+
+void loop() {
+  // Keep the queue topped up with a slow volume sweep
+  if (queue.pending() < PCM51XX_ASYNC_QUEUE_SIZE - 1) {
+    volume = volume < 0x60 ? volume + 1 : 0x30;
+    queue.write(0, PCM51XX_REG_DIGITAL_VOLUME_L, volume);
+    queue.write(0, PCM51XX_REG_DIGITAL_VOLUME_R, volume);
+  }
+
+  // At most one bus transfer per call
+  queue.poll();
+
+  if (millis() - last_report >= 1000) {
+    last_report = millis();
+    queue.read(0, PCM51XX_REG_POWER_STATE, nullptr, onPowerState);
+
+    pcm51xx_async_stats_t stats = queue.getStats();
+    Serial.print(F("Completed: "));
+    Serial.print(stats.completed);
+    Serial.print(F(" ops/s, failed: "));
+    Serial.print(stats.failed);
+    Serial.print(F(", transfers: "));
+    Serial.print(stats.transfers);
+    Serial.print(F(", blocked: "));
+    Serial.print(stats.blocked_us);
+    Serial.println(F(" us"));
+    queue.resetStats();
+  }
+}
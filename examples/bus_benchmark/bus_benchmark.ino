@@ -0,0 +1,149 @@
+/*!
+ * @file bus_benchmark.ino
+ *
+ * Bus cost benchmark for the Adafruit PCM51xx library
+ *
+ * Runs every public API call once, with the register cache off and then
+ * on, and prints one CSV line per call with the number of bus
+ * transactions, bytes on the wire and the estimated transfer time at
+ * 100kHz / 400kHz / 1MHz I2C and at the 1MHz hardware SPI rate used by
+ * begin(cs_pin, &SPI). Save the output of two releases and diff them to
+ * catch changes in bus traffic. The host build in test/host runs this same
+ * suite against the simulator and diffs it with test/host/bus_benchmark.csv.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+// Run one call with fresh counters and print its cost
+#define BENCH(name, call) \
+  do {                    \
+    pcm.resetBusStats();  \
+    call;                 \
+    report(F(name));      \
+  } while (0)
+
+bool cached = false;
+
+/*!
+ * @brief Estimate transfer time in microseconds
+ *
+ * I2C sends 9 bits per byte (data + ACK), plus the device address byte,
+ * START and STOP for every transaction, and a repeated START with a second
+ * address byte for reads. SPI sends 8 bits per byte with no addressing.
+ * Scaled by 10 to keep the math in 32 bits.
+ */
+uint32_t estimateI2C(pcm51xx_bus_stats_t& stats, uint32_t hz) {
+  uint32_t bits = stats.transactions * (9 + 2) + stats.reads * (9 + 1) +
+                  (stats.bytes_written + stats.bytes_read) * 9;
+  return (bits * 100000UL + hz / 10 - 1) / (hz / 10);
+}
+
+uint32_t estimateSPI(pcm51xx_bus_stats_t& stats, uint32_t hz) {
+  uint32_t bits = (stats.bytes_written + stats.bytes_read) * 8;
+  return (bits * 100000UL + hz / 10 - 1) / (hz / 10);
+}
+
+void report(const __FlashStringHelper* name) {
+  pcm51xx_bus_stats_t stats = pcm.getBusStats();
+
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(cached ? 1 : 0);
+  Serial.print(',');
+  Serial.print(stats.transactions);
+  Serial.print(',');
+  Serial.print(stats.reads);
+  Serial.print(',');
+  Serial.print(stats.page_selects);
+  Serial.print(',');
+  Serial.print(stats.bytes_written);
+  Serial.print(',');
+  Serial.print(stats.bytes_read);
+  Serial.print(',');
+  Serial.print(estimateI2C(stats, 100000));
+  Serial.print(',');
+  Serial.print(estimateI2C(stats, 400000));
+  Serial.print(',');
+  Serial.print(estimateI2C(stats, 1000000));
+  Serial.print(',');
+  Serial.println(estimateSPI(stats, 1000000));
+}
+
+void runSuite() {
+  float left, right;
+
+  BENCH("begin", pcm.begin());
+  BENCH("resetRegisters", pcm.resetRegisters());
+  BENCH("resetModules", pcm.resetModules());
+  BENCH("standby", pcm.standby(false));
+  BENCH("isStandby", pcm.isStandby());
+  BENCH("powerdown", pcm.powerdown(false));
+  BENCH("isPowerdown", pcm.isPowerdown());
+  BENCH("setI2SFormat", pcm.setI2SFormat(PCM51XX_I2S_FORMAT_I2S));
+  BENCH("getI2SFormat", pcm.getI2SFormat());
+  BENCH("setI2SSize", pcm.setI2SSize(PCM51XX_I2S_SIZE_24BIT));
+  BENCH("getI2SSize", pcm.getI2SSize());
+  BENCH("setPLLReference", pcm.setPLLReference(PCM51XX_PLL_REF_BCK));
+  BENCH("getPLLReference", pcm.getPLLReference());
+  BENCH("setVolumeDB", pcm.setVolumeDB(-6.0, -6.0));
+  BENCH("getVolumeDB", pcm.getVolumeDB(&left, &right));
+  BENCH("getDSPBootDone", pcm.getDSPBootDone());
+  BENCH("getPowerState", pcm.getPowerState());
+  BENCH("ignoreFSDetect", pcm.ignoreFSDetect(true));
+  BENCH("ignoreBCKDetect", pcm.ignoreBCKDetect(true));
+  BENCH("ignoreSCKDetect", pcm.ignoreSCKDetect(true));
+  BENCH("ignoreClockHalt", pcm.ignoreClockHalt(true));
+  BENCH("ignoreClockMissing", pcm.ignoreClockMissing(true));
+  BENCH("disableClockAutoset", pcm.disableClockAutoset(false));
+  BENCH("ignorePLLUnlock", pcm.ignorePLLUnlock(true));
+  BENCH("setDACSource", pcm.setDACSource(PCM51XX_DAC_CLK_PLL));
+  BENCH("getDACSource", pcm.getDACSource());
+  BENCH("setAutoMute", pcm.setAutoMute(false));
+  BENCH("getAutoMute", pcm.getAutoMute());
+  BENCH("mute", pcm.mute(true));
+  BENCH("isMuted", pcm.isMuted());
+  BENCH("enablePLL", pcm.enablePLL(true));
+  BENCH("isPLLEnabled", pcm.isPLLEnabled());
+  BENCH("isPLLLocked", pcm.isPLLLocked());
+  BENCH("enableDeemphasis", pcm.enableDeemphasis(false));
+  BENCH("isDeemphasized", pcm.isDeemphasized());
+  BENCH("digitalRead", pcm.digitalRead(5));
+  BENCH("enableVCOM", pcm.enableVCOM(false));
+  BENCH("isVCOMEnabled", pcm.isVCOMEnabled());
+  BENCH("setVCOMPower", pcm.setVCOMPower(true));
+  BENCH("isVCOMPowered", pcm.isVCOMPowered());
+  BENCH("setGPIO5Output", pcm.setGPIO5Output(PCM51XX_GPIO5_OFF));
+  BENCH("getGPIO5Output", pcm.getGPIO5Output());
+  BENCH("setGPIODirection", pcm.setGPIODirection(5, false));
+  BENCH("setGPIORegisterOutput", pcm.setGPIORegisterOutput(5, false));
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+
+  Serial.println(F("method,cached,transactions,reads,page_selects,"
+                   "bytes_written,bytes_read,us_i2c_100k,us_i2c_400k,"
+                   "us_i2c_1m,us_spi_1m"));
+
+  cached = false;
+  pcm.enableCache(false);
+  runSuite();
+
+  cached = true;
+  pcm.enableCache(true);
+  runSuite();
+}
+
+void loop() {
+  delay(1000);
+}
@@ -0,0 +1,70 @@
+/*!
+ * @file bus_recovery.ino
+ *
+ * Bus error recovery example for the Adafruit PCM51xx library
+ *
+ * Retries failed transfers with exponential backoff, and after any bus
+ * error checks whether the DAC reset (e.g. a brown-out) and reapplies its
+ * configuration. Every few seconds the error counters are printed; pull
+ * the DAC's power briefly to watch it recover.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Bus Recovery Test"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+
+  // The cache holds the configuration that is reapplied after a reset
+  pcm.enableCache(true);
+  pcm.setRetryPolicy(3, 200);
+  pcm.enableAutoRecover(true);
+
+  pcm.setI2SSize(PCM51XX_I2S_SIZE_24BIT);
+  pcm.setVolumeDB(-12.0, -12.0);
+  pcm.mute(false);
+}
+
+void loop() {
+  // A silent reset produces no bus error, so check for one now and then
+  if (!pcm.checkReset()) {
+    Serial.println(F("DAC not responding"));
+  }
+
+  pcm51xx_power_state_t state = pcm.getPowerState();
+  pcm51xx_error_t error = pcm.getLastError();
+  if (error == PCM51XX_ERROR_BUS) {
+    Serial.println(F("Power state unknown (bus error)"));
+  } else {
+    if (error == PCM51XX_ERROR_RESET) {
+      Serial.println(F("DAC had reset, configuration restored"));
+    }
+    Serial.print(F("Power state: "));
+    Serial.println(state);
+  }
+
+  pcm51xx_error_stats_t stats = pcm.getErrorStats();
+  Serial.print(F("Errors: "));
+  Serial.print(stats.errors);
+  Serial.print(F(", retries: "));
+  Serial.print(stats.retries);
+  Serial.print(F(", failures: "));
+  Serial.print(stats.failures);
+  Serial.print(F(", resets: "));
+  Serial.print(stats.resets);
+  Serial.print(F(", restores: "));
+  Serial.println(stats.restores);
+
+  delay(2000);
+}
@@ -0,0 +1,61 @@
+/*!
+ * @file bus_trace.ino
+ *
+ * Bus trace example for the Adafruit PCM51xx library
+ *
+ * Records every register access made by a few typical calls and prints the
+ * trace. Save the serial output and run pcm51xx_trace from the host build
+ * (test/host) on it to replay it on the chip simulator and list redundant
+ * writes, unnecessary reads and page thrash:
+ *
+ *     build-host/pcm51xx_trace -r serial.log
+ *
+ * The trace is only compiled in when the library is built with
+ * PCM51XX_TRACE defined, e.g. with build_flags = -DPCM51XX_TRACE in
+ * PlatformIO or compiler.cpp.extra_flags=-DPCM51XX_TRACE in Arduino's
+ * platform.local.txt. Without it the sketch just says so.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Bus Trace"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+
+#ifdef PCM51XX_TRACE
+  // Leave begin() out of the trace
+  pcm.clearTrace();
+#else
+  Serial.println(F("Build with PCM51XX_TRACE to record the bus trace"));
+#endif
+
+  // Setting the same volume twice with the cache off shows up as
+  // redundant writes, the status calls as reads
+  pcm.setVolumeDB(-20.0, -20.0);
+  pcm.setVolumeDB(-20.0, -20.0);
+  pcm.mute(true);
+  pcm.mute(false);
+  pcm.isPLLLocked();
+  pcm.getPowerState();
+  pcm.setVCOMPower(true);
+  pcm.isVCOMPowered();
+
+#ifdef PCM51XX_TRACE
+  pcm.dumpTrace(&Serial);
+#endif
+}
+
+void loop() {
+  delay(1000);
+}
@@ -0,0 +1,48 @@
+/*!
+ * @file footprint.ino
+ *
+ * Footprint example for the Adafruit PCM51xx library
+ *
+ * A minimal sketch (begin, volume, power state) used to measure the flash
+ * and RAM the library costs in each build configuration. Run
+ * tools/footprint.sh to build it with every combination of
+ * PCM51XX_I2C_ONLY, PCM51XX_SPI_ONLY and PCM51XX_NO_CACHE and print a
+ * table, or build it by hand with e.g.
+ *
+ *   arduino-cli compile -b arduino:avr:uno \
+ *     --build-property compiler.cpp.extra_flags=-DPCM51XX_I2C_ONLY
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.print(F("Driver object: "));
+  Serial.print(sizeof(pcm));
+  Serial.println(F(" bytes of RAM"));
+
+#ifndef PCM51XX_SPI_ONLY
+  bool found = pcm.begin();
+#else
+  bool found = pcm.begin(10, &SPI); // CS pin 10
+#endif
+  if (!found) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+
+  pcm.setVolumeDB(-6.0, -6.0);
+  pcm.mute(false);
+}
+
+void loop() {
+  Serial.print(F("Power state: "));
+  Serial.println(pcm.getPowerState());
+  delay(1000);
+}
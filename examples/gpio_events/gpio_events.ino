@@ -0,0 +1,71 @@
+/*!
+ * @file gpio_events.ino
+ *
+ * Interrupt-driven status example for the Adafruit PCM51xx library
+ *
+ * Routes the PLL lock, clock invalid and under-voltage flags to DAC GPIO3,
+ * GPIO4 and GPIO6, and reports them as they change. Wire each DAC GPIO to
+ * an interrupt-capable MCU pin (see the pin numbers below). Between
+ * changes the bus stays idle: handleEvents() only reads the DAC after one
+ * of the pins toggled.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+// MCU pins wired to DAC GPIO3, GPIO4 and GPIO6
+const uint8_t pll_pin = 2;
+const uint8_t clock_pin = 3;
+const uint8_t voltage_pin = 7;
+
+void onStatus(pcm51xx_event_t event, bool active) {
+  switch (event) {
+    case PCM51XX_EVENT_PLL_UNLOCK:
+      Serial.print(F("PLL "));
+      Serial.println(active ? F("unlocked") : F("locked"));
+      break;
+    case PCM51XX_EVENT_CLOCK_ERROR:
+      Serial.print(F("Clock "));
+      Serial.println(active ? F("invalid") : F("valid"));
+      break;
+    case PCM51XX_EVENT_UNDER_VOLTAGE:
+      Serial.print(F("DVDD "));
+      Serial.println(active ? F("under voltage") : F("ok"));
+      break;
+    default:
+      break;
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx GPIO Events Test"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+
+  pcm.routeEvent(PCM51XX_EVENT_PLL_UNLOCK, 3);
+  pcm.routeEvent(PCM51XX_EVENT_CLOCK_ERROR, 4);
+  pcm.routeEvent(PCM51XX_EVENT_UNDER_VOLTAGE, 6);
+  pcm.onEvent(PCM51XX_EVENT_PLL_UNLOCK, onStatus);
+  pcm.onEvent(PCM51XX_EVENT_CLOCK_ERROR, onStatus);
+  pcm.onEvent(PCM51XX_EVENT_UNDER_VOLTAGE, onStatus);
+
+  if (!pcm.attachEventPin(pll_pin) || !pcm.attachEventPin(clock_pin) ||
+      !pcm.attachEventPin(voltage_pin)) {
+    Serial.println(F("Could not attach interrupts, check pin numbers!"));
+    while (1) delay(10);
+  }
+}
+
+void loop() {
+  // No bus traffic unless a flag pin changed
+  pcm.handleEvents();
+}
@@ -0,0 +1,58 @@
+/*!
+ * @file instrumentation.ino
+ *
+ * Instrumentation example for the Adafruit PCM51xx library
+ *
+ * Runs a short mix of volume, mute and status calls, then prints the
+ * per-register transfer counts and per-call latency histograms gathered
+ * by the library. The counters are only compiled in when the library is
+ * built with PCM51XX_INSTRUMENT defined, e.g. with
+ * build_flags = -DPCM51XX_INSTRUMENT in PlatformIO or
+ * compiler.cpp.extra_flags=-DPCM51XX_INSTRUMENT in Arduino's
+ * platform.local.txt. Without it the sketch just says so.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Instrumentation"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+  pcm.enableCache(true);
+
+#ifdef PCM51XX_INSTRUMENT
+  // Only count the workload below, not begin()
+  pcm.resetInstrumentation();
+#else
+  Serial.println(F("Build with PCM51XX_INSTRUMENT to enable the counters"));
+#endif
+}
+
+void loop() {
+  pcm51xx_status_t status;
+
+  // Encoder sweep, a mute toggle and a status poll
+  for (int16_t half_db = -40; half_db > -60; half_db--) {
+    pcm.setVolumeHalfDB(half_db, half_db);
+  }
+  pcm.mute(true);
+  pcm.mute(false);
+  pcm.getStatus(&status);
+
+#ifdef PCM51XX_INSTRUMENT
+  pcm.dumpInstrumentation(&Serial);
+  Serial.println();
+#endif
+
+  delay(5000);
+}
@@ -72,9 +72,18 @@ void loop() {
   if (millis() - lastCheck > 3000) {
     lastCheck = millis();
     
-    bool pllLocked = pcm.isPLLLocked();
+    // One status snapshot instead of a read per flag
+    pcm51xx_status_t status;
+    if (!pcm.getStatus(&status)) {
+      Serial.println(F("Status read failed"));
+      return;
+    }
     Serial.print(F("PLL: "));
-    Serial.println(pllLocked ? F("LOCKED") : F("UNLOCKED"));
+    Serial.print(status.pll_locked ? F("LOCKED") : F("UNLOCKED"));
+    Serial.print(F(", power state: "));
+    Serial.print(status.power_state);
+    Serial.print(F(", clock errors: 0x"));
+    Serial.println(status.clock.errors, HEX);
   }
   
   delay(100);
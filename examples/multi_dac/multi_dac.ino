@@ -0,0 +1,81 @@
+/*!
+ * @file multi_dac.ino
+ *
+ * Multi-DAC example for the Adafruit PCM51xx library
+ *
+ * Drives four PCM51xx DACs on one I2C bus (addresses 0x4C to 0x4F) as an
+ * 8-channel array: one clock plan is computed and programmed on all of
+ * them, their clock dividers are restarted together, then every channel
+ * gets its own volume from a map. Prints how long each step took and the
+ * bus traffic of the first DAC.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm[4];
+Adafruit_PCM51xx_Array dacs;
+
+// Volume of each channel in 0.5dB steps: left/right of each DAC in turn
+const int16_t volume_map[8] = {-12, -12, -20, -20, -6, -6, -30, -30};
+
+void printStep(const __FlashStringHelper* name, bool ok, uint32_t us) {
+  Serial.print(name);
+  Serial.print(ok ? F(": ok in ") : F(": failed (mask 0x"));
+  if (!ok) {
+    Serial.print(dacs.getFailed(), HEX);
+    Serial.print(F(") in "));
+  }
+  Serial.print(us);
+  Serial.println(F(" us"));
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Multi-DAC Test"));
+
+  for (uint8_t i = 0; i < 4; i++) {
+    if (!pcm[i].begin(0x4C + i)) {
+      Serial.print(F("Could not find PCM51xx at 0x"));
+      Serial.println(0x4C + i, HEX);
+      while (1) delay(10);
+    }
+    pcm[i].enableCache(true);
+    dacs.add(&pcm[i]);
+  }
+
+  // 48kHz, 32-bit I2S with the PLL locked to BCK (3.072MHz)
+  pcm51xx_clock_plan_t plan;
+  if (!Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_BCK,
+                                    3072000, 48000, PCM51XX_I2S_SIZE_32BIT,
+                                    &plan)) {
+    Serial.println(F("No clock plan for this rate"));
+    while (1) delay(10);
+  }
+
+  pcm[0].resetBusStats();
+  uint32_t start = micros();
+  bool ok = dacs.applyClockPlan(&plan);
+  printStep(F("Clock plan"), ok, micros() - start);
+
+  start = micros();
+  ok = dacs.setVolumeMap(volume_map);
+  printStep(F("Volume map"), ok, micros() - start);
+
+  start = micros();
+  ok = dacs.mute(false);
+  printStep(F("Unmute"), ok, micros() - start);
+
+  pcm51xx_bus_stats_t stats = pcm[0].getBusStats();
+  Serial.print(F("DAC 0 bus transactions: "));
+  Serial.print(stats.transactions);
+  Serial.print(F(", bytes written: "));
+  Serial.println(stats.bytes_written);
+}
+
+void loop() {
+  delay(1000);
+}
@@ -0,0 +1,75 @@
+/*!
+ * @file nonblocking_startup.ino
+ *
+ * Non-blocking bring-up example for the Adafruit PCM51xx library
+ *
+ * Resets the DAC modules, leaves standby and waits for the playing state
+ * without ever blocking loop(), then reports how long each step took and
+ * how many status reads it needed. The LED keeps blinking throughout to
+ * show the main loop is never stalled.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+// Bring-up steps, run in order
+const pcm51xx_op_t steps[] = {PCM51XX_OP_RESET_MODULES,
+                              PCM51XX_OP_EXIT_STANDBY,
+                              PCM51XX_OP_WAIT_PLAYING};
+const uint8_t num_steps = sizeof(steps) / sizeof(steps[0]);
+uint8_t step = 0;
+bool started = false;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Non-blocking Startup"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+
+  pinMode(LED_BUILTIN, OUTPUT);
+}
+
+void loop() {
+  // Other work keeps running while the DAC comes up
+  digitalWrite(LED_BUILTIN, (millis() / 250) & 1);
+
+  if (step >= num_steps) {
+    return;
+  }
+
+  if (!started) {
+    started = true;
+    if (!pcm.startOperation(steps[step])) {
+      Serial.println(F("Could not start operation"));
+    }
+  }
+
+  pcm51xx_op_status_t status = pcm.pollOperation();
+  if (status == PCM51XX_OP_BUSY) {
+    return;
+  }
+
+  pcm51xx_op_info_t info = pcm.getOperation();
+  Serial.print(F("Step "));
+  Serial.print(step + 1);
+  Serial.print(status == PCM51XX_OP_DONE ? F(" done in ")
+                                         : F(" failed after "));
+  Serial.print(info.elapsed);
+  Serial.print(F(" us, "));
+  Serial.print(info.polls);
+  Serial.println(F(" polls"));
+
+  started = false;
+  step = status == PCM51XX_OP_DONE ? step + 1 : num_steps;
+  if (step == num_steps && status == PCM51XX_OP_DONE) {
+    Serial.println(F("Ready to play audio!"));
+  }
+}
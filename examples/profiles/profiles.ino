@@ -0,0 +1,104 @@
+/*!
+ * @file profiles.ino
+ *
+ * Configuration profile example for the Adafruit PCM51xx library
+ *
+ * Captures a line-out and a headphone configuration as register profiles,
+ * prints the registers that differ and switches between the two with
+ * applyProfile(), which only writes what changed. The headphone profile is
+ * also printed as a C initializer that can be pasted into a sketch as a
+ * PROGMEM table and applied with applyProfile(&profile, true).
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+pcm51xx_profile_t line_out;
+pcm51xx_profile_t headphone;
+
+void printHex(uint8_t value) {
+  Serial.print(F("0x"));
+  if (value < 0x10) {
+    Serial.print('0');
+  }
+  Serial.print(value, HEX);
+}
+
+void printDiffs() {
+  pcm51xx_reg_write_t diffs[PCM51XX_PROFILE_SIZE];
+  uint8_t count = Adafruit_PCM51xx::diffProfiles(&line_out, &headphone, diffs,
+                                                 PCM51XX_PROFILE_SIZE);
+  Serial.print(count);
+  Serial.println(F(" registers differ:"));
+  for (uint8_t i = 0; i < count; i++) {
+    Serial.print(F("  page "));
+    Serial.print(diffs[i].page);
+    Serial.print(F(" reg "));
+    printHex(diffs[i].reg);
+    Serial.print(F(" -> "));
+    printHex(diffs[i].value);
+    Serial.println();
+  }
+}
+
+void printInitializer(const pcm51xx_profile_t& profile) {
+  Serial.println(F("const pcm51xx_profile_t profile PROGMEM = {{"));
+  for (uint8_t i = 0; i < PCM51XX_PROFILE_SIZE; i++) {
+    Serial.print(i % 8 ? F(" ") : F("    "));
+    printHex(profile.values[i]);
+    Serial.print(',');
+    if (i % 8 == 7 || i == PCM51XX_PROFILE_SIZE - 1) {
+      Serial.println();
+    }
+  }
+  Serial.println(F("}};"));
+}
+
+void switchTo(const pcm51xx_profile_t& profile,
+              const __FlashStringHelper* name) {
+  pcm.resetBusStats();
+  bool ok = pcm.applyProfile(&profile);
+  Serial.print(F("Switched to "));
+  Serial.print(name);
+  Serial.print(ok ? F(" in ") : F(" (failed) in "));
+  Serial.print(pcm.getBusStats().transactions);
+  Serial.println(F(" bus transactions"));
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Profiles"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+  pcm.enableCache(true);
+
+  // Line out: 2Vrms output, 0dB
+  pcm.setVolumeDB(0.0, 0.0);
+  pcm.captureProfile(&line_out);
+
+  // Headphone: VCOM output, quieter, GPIO5 drives an amplifier enable
+  pcm.enableVCOM(true);
+  pcm.setVolumeDB(-20.0, -20.0);
+  pcm.setGPIODirection(5, true);
+  pcm.setGPIO5Output(PCM51XX_GPIO5_REGISTER_OUTPUT);
+  pcm.setGPIORegisterOutput(5, true);
+  pcm.captureProfile(&headphone);
+
+  printDiffs();
+  printInitializer(headphone);
+}
+
+void loop() {
+  switchTo(line_out, F("line out"));
+  delay(5000);
+  switchTo(headphone, F("headphone"));
+  delay(5000);
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file rtos_tasks.ino
+ *
+ * Multi-task example for the Adafruit PCM51xx library (ESP32 / FreeRTOS)
+ *
+ * A UI task and a control task both change the DAC. Each posts its writes
+ * to its own lock-free command queue, and the audio task that owns the DAC
+ * drains both queues, so page selects and read-modify-writes from the two
+ * tasks can never interleave. Direct calls from other tasks are made safe
+ * with a recursive mutex passed to setLock().
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+Adafruit_PCM51xx_CommandQueue ui_queue;
+Adafruit_PCM51xx_CommandQueue control_queue;
+SemaphoreHandle_t pcm_mutex;
+
+void lockPCM(void* arg) {
+  xSemaphoreTakeRecursive((SemaphoreHandle_t)arg, portMAX_DELAY);
+}
+
+void unlockPCM(void* arg) { xSemaphoreGiveRecursive((SemaphoreHandle_t)arg); }
+
+// Volume knob: sweeps both channels between -40dB and -10dB
+void uiTask(void* arg) {
+  (void)arg;
+  int16_t half_db = -80;
+  for (;;) {
+    half_db = half_db < -20 ? half_db + 1 : -80;
+    uint8_t reg = pcm51xx_half_db_to_reg(half_db);
+    ui_queue.post(0, PCM51XX_REG_DIGITAL_VOLUME_L, 0xFF, reg);
+    ui_queue.post(0, PCM51XX_REG_DIGITAL_VOLUME_R, 0xFF, reg);
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+}
+
+// Remote control: toggles the VCOM output mode on page 1 now and then
+void controlTask(void* arg) {
+  (void)arg;
+  bool vcom = false;
+  for (;;) {
+    vcom = !vcom;
+    control_queue.postField<PCM51XX_FIELD_OUTPUT_AMP_TYPE>(vcom ? 1 : 0);
+    vTaskDelay(pdMS_TO_TICKS(500));
+  }
+}
+
+// Owner of the DAC: applies what the other tasks posted
+void audioTask(void* arg) {
+  (void)arg;
+  for (;;) {
+    ui_queue.drain(&pcm);
+    control_queue.drain(&pcm);
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx RTOS Tasks Test"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+  pcm.enableCache(true);
+
+  pcm_mutex = xSemaphoreCreateRecursiveMutex();
+  pcm.setLock(lockPCM, unlockPCM, pcm_mutex);
+
+  xTaskCreate(uiTask, "ui", 2048, nullptr, 1, nullptr);
+  xTaskCreate(controlTask, "control", 2048, nullptr, 1, nullptr);
+  xTaskCreate(audioTask, "audio", 4096, nullptr, 2, nullptr);
+}
+
+void loop() {
+  // Direct calls from another task are serialised by the lock
+  Serial.print(F("Power state: "));
+  Serial.print(pcm.getPowerState());
+  Serial.print(F(", dropped writes: "));
+  Serial.println(ui_queue.getDropped() + control_queue.getDropped());
+  delay(1000);
+}
@@ -39,6 +39,11 @@ void setup() {
   // }
   
   Serial.println(F("PCM51xx initialized successfully!"));
+  Serial.print(F("Boot took "));
+  Serial.print(pcm.getBootTime());
+  Serial.print(F(" us in "));
+  Serial.print(pcm.getBootTransactions());
+  Serial.println(F(" bus transactions"));
 
   // Set I2S format to I2S
   Serial.println(F("Setting I2S format"));
@@ -0,0 +1,113 @@
+/*!
+ * @file volume_benchmark.ino
+ *
+ * Volume API benchmark for the Adafruit PCM51xx library
+ *
+ * Compares the float setVolumeDB() path with the integer half-dB API:
+ * first the dB to register conversion alone, then whole calls as a rotary
+ * encoder would make them (one channel changing at a time, cache on),
+ * with the time and bus transactions per call.
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+Adafruit_PCM51xx pcm;
+
+const uint16_t conversions = 1000;
+const uint16_t calls = 100;
+
+// volatile keeps the compiler from folding the conversions away
+volatile float float_db = -20.0;
+volatile int16_t half_db = -40;
+volatile uint8_t sink;
+
+void printPerCall(const __FlashStringHelper* name, uint32_t us,
+                  uint16_t count) {
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print((float)us / count, 3);
+  Serial.print(F(" us/call"));
+#ifdef F_CPU
+  Serial.print(F(", ~"));
+  Serial.print((uint32_t)((float)us * (F_CPU / 1000000UL) / count));
+  Serial.print(F(" cycles/call"));
+#endif
+  Serial.println();
+}
+
+void printBus() {
+  pcm51xx_bus_stats_t stats = pcm.getBusStats();
+  Serial.print(F("  bus transactions: "));
+  Serial.print(stats.transactions);
+  Serial.print(F(", bytes written: "));
+  Serial.println(stats.bytes_written);
+}
+
+void benchConversions() {
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < conversions; i++) {
+    sink = (uint8_t)constrain((24.0 - float_db) / 0.5, 0, 255);
+  }
+  printPerCall(F("float conversion"), micros() - start, conversions);
+
+  start = micros();
+  for (uint16_t i = 0; i < conversions; i++) {
+    sink = pcm51xx_half_db_to_reg(half_db);
+  }
+  printPerCall(F("half-dB conversion"), micros() - start, conversions);
+}
+
+void benchCalls() {
+  pcm.setVolumeHalfDB(-40, -40);
+
+  // Encoder turning the left channel down in 0.5dB steps
+  pcm.resetBusStats();
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < calls; i++) {
+    pcm.setVolumeDB(-20.0 - i * 0.5, -20.0);
+  }
+  uint32_t elapsed = micros() - start;
+  printPerCall(F("setVolumeDB"), elapsed, calls);
+  printBus();
+
+  pcm.setVolumeHalfDB(-40, -40);
+  pcm.resetBusStats();
+  start = micros();
+  for (uint16_t i = 0; i < calls; i++) {
+    pcm.setVolumeHalfDB(-40 - i, -40);
+  }
+  elapsed = micros() - start;
+  printPerCall(F("setVolumeHalfDB"), elapsed, calls);
+  printBus();
+
+  pcm.resetBusStats();
+  start = micros();
+  for (uint16_t i = 0; i < calls; i++) {
+    pcm.setLeftVolumeHalfDB(-40 - i);
+  }
+  elapsed = micros() - start;
+  printPerCall(F("setLeftVolumeHalfDB"), elapsed, calls);
+  printBus();
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println(F("Adafruit PCM51xx Volume Benchmark"));
+
+  if (!pcm.begin()) {
+    Serial.println(F("Could not find PCM51xx, check wiring!"));
+    while (1) delay(10);
+  }
+  pcm.enableCache(true);
+
+  benchConversions();
+  benchCalls();
+}
+
+void loop() {
+  delay(1000);
+}
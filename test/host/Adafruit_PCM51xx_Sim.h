@@ -0,0 +1,112 @@
+/*!
+ * @file Adafruit_PCM51xx_Sim.h
+ *
+ * Register-level PCM51xx simulator for host builds
+ *
+ * Each simulator answers on the host I2C bus at its address and, if given a
+ * chip select pin, on the host SPI bus, so an Adafruit_PCM51xx built against
+ * the host shim talks to it exactly as it would to a real chip.
+ */
+
+#ifndef _ADAFRUIT_PCM51XX_SIM_H
+#define _ADAFRUIT_PCM51XX_SIM_H
+
+#include <Adafruit_PCM51xx.h>
+
+#include <mutex>
+#include <vector>
+
+/*! @brief Most simulated chips on the host buses at once */
+#define PCM51XX_SIM_MAX 8
+/*! @brief Time the reset bits take to clear themselves */
+#define PCM51XX_SIM_RESET_US 100
+/*! @brief Time a coefficient buffer swap takes */
+#define PCM51XX_SIM_SWAP_US 50
+/*! @brief Time the PLL takes to lock once enabled */
+#define PCM51XX_SIM_PLL_LOCK_US 1000
+/*! @brief Time spent ramping up after leaving standby or powerdown */
+#define PCM51XX_SIM_POWER_UP_US 500
+
+/*! @brief One register access seen by the simulator */
+typedef struct {
+  uint8_t page;  ///< Page the access landed on
+  uint8_t reg;   ///< Register address
+  uint8_t value; ///< Value written or read
+  bool write;    ///< True for a write
+} pcm51xx_sim_access_t;
+
+/*! @brief Bus traffic seen by the simulator, counted like getBusStats() */
+typedef struct {
+  uint32_t transactions;  ///< Transfers addressed to the chip
+  uint32_t reads;         ///< Transfers that read data back
+  uint32_t bytes_written; ///< Register address and data bytes received
+  uint32_t bytes_read;    ///< Data bytes sent back
+  uint32_t ignored;       ///< Writes to read-only bits that were dropped
+} pcm51xx_sim_stats_t;
+
+/*!
+ * @brief Simulated PCM51xx
+ *
+ * Models page select, the self-clearing reset and coefficient swap bits,
+ * the read-only status registers, PLL lock after enabling the PLL and the
+ * power state following the standby and powerdown requests. Time comes
+ * from micros(), which the host shim simulates.
+ */
+class Adafruit_PCM51xx_Sim {
+ public:
+  Adafruit_PCM51xx_Sim(uint8_t i2c_addr = PCM51XX_DEFAULT_ADDR,
+                       int8_t cs_pin = -1);
+  ~Adafruit_PCM51xx_Sim(void);
+
+  void powerCycle(void);
+  uint8_t getPage(void);
+  uint8_t peek(uint8_t page, uint8_t reg);
+  void poke(uint8_t page, uint8_t reg, uint8_t value);
+  void writeRegister(uint8_t reg, uint8_t value);
+  uint8_t readRegister(uint8_t reg);
+  static bool isVolatile(uint8_t page, uint8_t reg);
+
+  void setPLLLockable(bool lockable);
+  void failTransfers(uint16_t count);
+  void loseAcks(uint16_t count);
+
+  pcm51xx_sim_stats_t getStats(void);
+  void resetStats(void);
+  void enableLog(bool enable);
+  std::vector<pcm51xx_sim_access_t> getLog(void);
+  void clearLog(void);
+
+  static Adafruit_PCM51xx_Sim* findI2C(uint8_t addr);
+  static Adafruit_PCM51xx_Sim* findSPI(int8_t cs);
+  bool transfer(const uint8_t* write_buffer, size_t write_len,
+                uint8_t* read_buffer, size_t read_len, bool spi);
+
+ private:
+  static uint8_t writeMask(uint8_t page, uint8_t reg);
+  void update(void);
+  void store(uint8_t reg, uint8_t value);
+  uint8_t load(uint8_t reg);
+  void log(uint8_t reg, uint8_t value, bool write);
+
+  uint8_t _i2c_addr;           ///< I2C address answered
+  int8_t _cs_pin;              ///< SPI chip select answered, or -1
+  std::recursive_mutex _mutex; ///< Serialises bus and test access
+  uint8_t _regs[256][128];     ///< Register file of every page
+  uint8_t _page;               ///< Selected page
+  uint8_t _pointer;            ///< Register a bare I2C read starts at
+  uint32_t _reset_start;       ///< When a reset bit was set
+  uint32_t _swap_start;        ///< When a buffer swap was requested
+  uint32_t _pll_start;         ///< When the PLL was enabled
+  uint32_t _run_start;         ///< When standby and powerdown were left
+  bool _pll_lockable;          ///< A reference clock is present
+  uint16_t _fail;              ///< Transfers left to fail outright
+  uint16_t _lose;              ///< Writes left to land but report failure
+  pcm51xx_sim_stats_t _stats;  ///< Bus traffic counters
+  bool _log_enabled;           ///< Recording accesses in _log
+  /*! @brief Recorded accesses */
+  std::vector<pcm51xx_sim_access_t> _log;
+
+  static Adafruit_PCM51xx_Sim* _sims[PCM51XX_SIM_MAX]; ///< Chips on the buses
+};
+
+#endif
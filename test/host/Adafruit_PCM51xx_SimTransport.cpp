@@ -0,0 +1,124 @@
+/*!
+ * @file Adafruit_PCM51xx_SimTransport.cpp
+ *
+ * Asynchronous transport backed by the PCM51xx simulator
+ */
+
+#include "Adafruit_PCM51xx_SimTransport.h"
+
+/*!
+ * @brief Constructor
+ * @param sim Chip the transfers reach, over its I2C interface
+ * @param latency Number of poll() calls reporting a transfer busy
+ */
+Adafruit_PCM51xx_SimTransport::Adafruit_PCM51xx_SimTransport(
+    Adafruit_PCM51xx_Sim* sim, uint8_t latency) {
+  _sim = sim;
+  _latency = latency;
+  _remaining = 0;
+  _busy = false;
+  _reg = 0;
+  _write_buffer = nullptr;
+  _read_buffer = nullptr;
+  _len = 0;
+  _started = 0;
+}
+
+/*!
+ * @brief Start writing consecutive registers
+ * @param reg First register address
+ * @param buffer Data to write, kept until poll() reports the end
+ * @param len Number of bytes
+ * @return True if the transfer was started, false if one is in flight
+ */
+bool Adafruit_PCM51xx_SimTransport::startWrite(uint8_t reg,
+                                               const uint8_t* buffer,
+                                               uint8_t len) {
+  if (!start(reg, len)) {
+    return false;
+  }
+  _write_buffer = buffer;
+  _read_buffer = nullptr;
+  return true;
+}
+
+/*!
+ * @brief Start reading consecutive registers
+ * @param reg First register address
+ * @param buffer Buffer filled when poll() reports the end
+ * @param len Number of bytes
+ * @return True if the transfer was started, false if one is in flight
+ */
+bool Adafruit_PCM51xx_SimTransport::startRead(uint8_t reg, uint8_t* buffer,
+                                              uint8_t len) {
+  if (!start(reg, len)) {
+    return false;
+  }
+  _write_buffer = nullptr;
+  _read_buffer = buffer;
+  return true;
+}
+
+/*!
+ * @brief Check on the transfer last started
+ *
+ * The transfer is carried out by the call that reports its end, so
+ * nothing reaches the simulator while it is reported busy.
+ *
+ * @return PCM51XX_TRANSFER_BUSY until it ends, then its result
+ */
+pcm51xx_transfer_t Adafruit_PCM51xx_SimTransport::poll(void) {
+  if (!_busy) {
+    return PCM51XX_TRANSFER_ERROR;
+  }
+  if (_remaining) {
+    _remaining--;
+    return PCM51XX_TRANSFER_BUSY;
+  }
+
+  _busy = false;
+  uint8_t buffer[1 + 255];
+  buffer[0] = _reg | PCM51XX_AUTO_INCREMENT;
+  bool ok;
+  if (_write_buffer) {
+    memcpy(buffer + 1, _write_buffer, _len);
+    ok = _sim->transfer(buffer, 1 + _len, nullptr, 0, false);
+  } else {
+    ok = _sim->transfer(buffer, 1, _read_buffer, _len, false);
+  }
+  return ok ? PCM51XX_TRANSFER_DONE : PCM51XX_TRANSFER_ERROR;
+}
+
+/*!
+ * @brief Check for a transfer in flight
+ * @return True between a start call and the poll() reporting its end
+ */
+bool Adafruit_PCM51xx_SimTransport::busy(void) {
+  return _busy;
+}
+
+/*!
+ * @brief Get the number of transfers started
+ * @return Transfers started since construction
+ */
+uint32_t Adafruit_PCM51xx_SimTransport::getStarted(void) {
+  return _started;
+}
+
+/*!
+ * @brief Record the common part of a new transfer
+ * @param reg First register address
+ * @param len Number of bytes
+ * @return True if started, false if a transfer is already in flight
+ */
+bool Adafruit_PCM51xx_SimTransport::start(uint8_t reg, uint8_t len) {
+  if (_busy || !len) {
+    return false;
+  }
+  _busy = true;
+  _remaining = _latency;
+  _reg = reg;
+  _len = len;
+  _started++;
+  return true;
+}
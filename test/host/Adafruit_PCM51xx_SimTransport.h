@@ -0,0 +1,45 @@
+/*!
+ * @file Adafruit_PCM51xx_SimTransport.h
+ *
+ * Asynchronous transport backed by the PCM51xx simulator
+ */
+
+#ifndef _ADAFRUIT_PCM51XX_SIMTRANSPORT_H
+#define _ADAFRUIT_PCM51XX_SIMTRANSPORT_H
+
+#include "Adafruit_PCM51xx_Sim.h"
+
+/*!
+ * @brief Transport that completes transfers on a later poll()
+ *
+ * Behaves like a DMA or interrupt-driven bus driver: a start call only
+ * records the transfer, poll() reports it busy a set number of times and
+ * the transfer reaches the simulator on the poll that reports its end.
+ */
+class Adafruit_PCM51xx_SimTransport : public Adafruit_PCM51xx_Transport {
+ public:
+  Adafruit_PCM51xx_SimTransport(Adafruit_PCM51xx_Sim* sim,
+                                uint8_t latency = 1);
+
+  bool startWrite(uint8_t reg, const uint8_t* buffer, uint8_t len);
+  bool startRead(uint8_t reg, uint8_t* buffer, uint8_t len);
+  pcm51xx_transfer_t poll(void);
+
+  bool busy(void);
+  uint32_t getStarted(void);
+
+ private:
+  bool start(uint8_t reg, uint8_t len);
+
+  Adafruit_PCM51xx_Sim* _sim;   ///< Chip the transfers reach
+  uint8_t _latency;             ///< Busy polls before a transfer ends
+  uint8_t _remaining;           ///< Busy polls left for this transfer
+  bool _busy;                   ///< Transfer in flight
+  uint8_t _reg;                 ///< First register of the transfer
+  const uint8_t* _write_buffer; ///< Data to write, or nullptr for a read
+  uint8_t* _read_buffer;        ///< Where a read lands, or nullptr
+  uint8_t _len;                 ///< Number of data bytes
+  uint32_t _started;            ///< Transfers started so far
+};
+
+#endif
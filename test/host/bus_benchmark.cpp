@@ -0,0 +1,19 @@
+/*!
+ * @file bus_benchmark.cpp
+ *
+ * Host build of the bus_benchmark example, run against the simulator
+ *
+ * Prints the same CSV the example prints on a board. ctest compares it
+ * with bus_benchmark.csv, so any change in bus traffic shows up as a diff.
+ */
+
+#include "Adafruit_PCM51xx_Sim.h"
+
+#include "../../examples/bus_benchmark/bus_benchmark.ino"
+
+int main(void) {
+  Adafruit_PCM51xx_Sim sim;
+
+  setup();
+  return 0;
+}
@@ -0,0 +1,20 @@
+/*!
+ * @file bus_trace.cpp
+ *
+ * Host build of the bus_trace example, run against the simulator
+ *
+ * Prints the same serial output the example prints on a board. ctest
+ * replays it with pcm51xx_trace and compares the report with
+ * bus_trace.txt.
+ */
+
+#include "Adafruit_PCM51xx_Sim.h"
+
+#include "../../examples/bus_trace/bus_trace.ino"
+
+int main(void) {
+  Adafruit_PCM51xx_Sim sim;
+
+  setup();
+  return 0;
+}
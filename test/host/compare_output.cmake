@@ -0,0 +1,31 @@
+# Run a program and compare what it prints with a saved baseline
+#
+#   cmake -DPROGRAM=<exe> [-DFILTER=<exe;args>] -DBASELINE=<file>
+#         -DOUTPUT=<file> -P compare_output.cmake
+#
+# If FILTER is given the program's output is piped through it first.
+# The output is kept in OUTPUT so it can be copied over the baseline when a
+# change in it is intended.
+
+if(FILTER)
+  execute_process(COMMAND ${PROGRAM}
+    COMMAND ${FILTER}
+    OUTPUT_FILE ${OUTPUT}
+    RESULTS_VARIABLE results)
+  list(REMOVE_DUPLICATES results)
+  set(result ${results})
+else()
+  execute_process(COMMAND ${PROGRAM}
+    OUTPUT_FILE ${OUTPUT}
+    RESULT_VARIABLE result)
+endif()
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${PROGRAM} failed: ${result}")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${BASELINE}
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  execute_process(COMMAND diff -u ${BASELINE} ${OUTPUT})
+  message(FATAL_ERROR "${OUTPUT} differs from ${BASELINE}")
+endif()
@@ -0,0 +1,40 @@
+/*!
+ * @file host_test.h
+ *
+ * Minimal check macros for the host tests
+ */
+
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+#include <stdio.h>
+
+static int host_test_failures = 0; ///< Failed checks so far
+
+/*! @brief Record a failure unless a condition holds */
+#define CHECK(cond)                                          \
+  do {                                                       \
+    if (!(cond)) {                                           \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, \
+              __LINE__, #cond);                              \
+      host_test_failures++;                                  \
+    }                                                        \
+  } while (0)
+
+/*! @brief Record a failure unless two integers are equal */
+#define CHECK_EQ(actual, expected)                                    \
+  do {                                                                \
+    long long a_ = (long long)(actual), e_ = (long long)(expected);   \
+    if (a_ != e_) {                                                   \
+      fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, \
+              __LINE__, #actual, a_, e_);                             \
+      host_test_failures++;                                           \
+    }                                                                 \
+  } while (0)
+
+/*! @brief Print the result and give the exit code for ctest */
+#define TEST_RESULT()                                                \
+  (printf("%s: %s\n", __FILE__, host_test_failures ? "FAIL" : "OK"), \
+   host_test_failures ? 1 : 0)
+
+#endif
@@ -0,0 +1,523 @@
+/*!
+ * @file pcm51xx_trace.cpp
+ *
+ * Replay a PCM51xx bus trace against the simulator and report wasteful
+ * register traffic
+ *
+ * Reads the output of Adafruit_PCM51xx::dumpTrace() (a library built with
+ * PCM51XX_TRACE) from a serial log and replays every register access on an
+ * Adafruit_PCM51xx_Sim, advancing its clock by the recorded time steps so
+ * reset bits clear and the PLL locks as they did on the board. Registers
+ * the simulator treats as volatile are never reported. It lists:
+ *
+ *   - redundant writes: a register written with the value it already holds
+ *   - unnecessary reads: a non-volatile register read while its value was
+ *     already known from an earlier read or write
+ *   - page thrash: page selects to the current page, and short visits to a
+ *     page before going straight back (A -> B -> A)
+ *   - read mismatches: a read returning something other than the value the
+ *     chip was last known to hold, e.g. after a brown-out reset
+ *
+ * Other lines in the log are ignored, so a whole serial capture can be
+ * passed in. Every trace found is reported on its own.
+ *
+ * Usage: pcm51xx_trace [-r] [-s] [-t N] [-w N] [log]   (default: stdin)
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Adafruit_PCM51xx_Sim.h"
+
+/*! @brief Page value while the selected page is not known */
+#define UNKNOWN_PAGE -1
+
+/*! @brief One register access from a trace */
+typedef struct {
+  uint8_t reg;      ///< Register address
+  bool write;       ///< True for a write
+  uint8_t value;    ///< Value written or read
+  bool failed;      ///< The transfer failed
+  uint16_t delta;   ///< Microseconds since the previous record
+  uint32_t time;    ///< micros() of the access
+  int16_t page;     ///< Page it landed on, filled in by the replay
+  const char* note; ///< Finding, filled in by the replay
+  uint8_t expected; ///< Value expected by a mismatching read
+} trace_record_t;
+
+/*! @brief A decoded dumpTrace() block */
+typedef struct {
+  int16_t page;     ///< Page selected before the first record
+  uint32_t dropped; ///< Older records overwritten
+  /*! @brief Accesses, oldest first */
+  std::vector<trace_record_t> records;
+} trace_t;
+
+/*! @brief Command line options */
+typedef struct {
+  bool records; ///< Print every access as it is replayed
+  bool state;   ///< Print the known register state at the end
+  int top;      ///< Registers to list in the summary
+  int window;   ///< Most accesses on a page for a return to be a bounce
+} options_t;
+
+/*! @brief Accesses to one register */
+typedef struct {
+  uint16_t key;         ///< Page in the high byte, register in the low
+  uint32_t reads;       ///< Reads
+  uint32_t writes;      ///< Writes
+  uint32_t redundant;   ///< Redundant writes
+  uint32_t unnecessary; ///< Unnecessary reads
+} reg_counts_t;
+
+/*!
+ * @brief Print an error and exit
+ * @param format printf() format of the message
+ */
+static void fail(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "pcm51xx_trace: ");
+  vfprintf(stderr, format, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+  exit(1);
+}
+
+/*!
+ * @brief Replays one trace on a simulated chip and counts what it finds
+ */
+class Replay {
+ public:
+  Replay(int16_t page, int window);
+  void run(trace_record_t* record);
+  void report(int number, const trace_t* trace, const options_t* options);
+
+ private:
+  void select(trace_record_t* record);
+  reg_counts_t* counts(uint8_t reg);
+  void forget(void);
+
+  Adafruit_PCM51xx_Sim _sim;         ///< Chip the accesses are replayed on
+  bool _known[256][128];             ///< Registers whose value is known
+  int16_t _page;                     ///< Selected page, or UNKNOWN_PAGE
+  int16_t _previous_page;            ///< Page selected before this one
+  int _visit;                        ///< Accesses since the last select
+  int _window;                       ///< Bounce window, see options_t
+  uint32_t _reads;                   ///< Successful reads
+  uint32_t _writes;                  ///< Successful writes
+  uint32_t _failed;                  ///< Failed transfers
+  uint32_t _page_selects;            ///< Page select writes
+  uint32_t _redundant_selects;       ///< Selects of the current page
+  uint32_t _bounces;                 ///< Short visits to another page
+  uint32_t _redundant_writes;        ///< Writes of the value already held
+  uint32_t _unnecessary_reads;       ///< Reads of a known value
+  uint32_t _mismatches;              ///< Reads differing from the known one
+  uint32_t _unknown_page;            ///< Accesses before any page select
+  std::vector<reg_counts_t> _counts; ///< Per register, in first-seen order
+};
+
+/*!
+ * @brief Constructor
+ * @param page Page selected when the trace starts, or UNKNOWN_PAGE
+ * @param window Most accesses on a page for a return to count as a bounce
+ */
+Replay::Replay(int16_t page, int window) {
+  forget();
+  _page = page;
+  if (page != UNKNOWN_PAGE) {
+    _sim.writeRegister(PCM51XX_REG_PAGE_SELECT, page);
+  }
+  _previous_page = UNKNOWN_PAGE;
+  _visit = 0;
+  _window = window;
+  _reads = _writes = _failed = 0;
+  _page_selects = _redundant_selects = _bounces = 0;
+  _redundant_writes = _unnecessary_reads = _mismatches = 0;
+  _unknown_page = 0;
+}
+
+/*!
+ * @brief Replay one access
+ * @param record Access to replay, its page and note are filled in
+ */
+void Replay::run(trace_record_t* record) {
+  // Lets reset bits clear and the PLL lock on the trace's own timing
+  hostAdvanceMicros(record->delta);
+  record->page = _page;
+
+  if (record->failed) {
+    _failed++;
+    if (record->write) {
+      if (record->reg == PCM51XX_REG_PAGE_SELECT) {
+        _page = UNKNOWN_PAGE;
+      } else if (_page != UNKNOWN_PAGE) {
+        _known[_page][record->reg] = false;
+      }
+    }
+    return;
+  }
+  if (record->reg == PCM51XX_REG_PAGE_SELECT) {
+    if (record->write) {
+      select(record);
+    }
+    return;
+  }
+  if (_page == UNKNOWN_PAGE) {
+    _unknown_page++;
+    return;
+  }
+
+  _visit++;
+  uint8_t reg = record->reg;
+  bool known = _known[_page][reg] &&
+               !Adafruit_PCM51xx_Sim::isVolatile(_page, reg);
+  uint8_t held = _sim.peek(_page, reg);
+  reg_counts_t* c = counts(reg);
+
+  if (record->write) {
+    _writes++;
+    c->writes++;
+    if (known && held == record->value) {
+      _redundant_writes++;
+      c->redundant++;
+      record->note = "redundant write";
+    }
+    _sim.writeRegister(reg, record->value);
+    _known[_page][reg] = true;
+    if (_page == 0 && reg == PCM51XX_REG_RESET &&
+        (record->value & PCM51XX_FIELD_RESET_REGISTERS::mask())) {
+      // Every register goes back to a default not in the trace
+      forget();
+    }
+    return;
+  }
+
+  _reads++;
+  c->reads++;
+  if (known && held == record->value) {
+    _unnecessary_reads++;
+    c->unnecessary++;
+    record->note = "unnecessary read";
+  } else if (known) {
+    _mismatches++;
+    record->note = "mismatch, expected";
+    record->expected = held;
+  }
+  // The chip had this value, whatever the simulator thought
+  _sim.poke(_page, reg, record->value);
+  _known[_page][reg] = true;
+}
+
+/*!
+ * @brief Replay a page select
+ * @param record Page select write
+ */
+void Replay::select(trace_record_t* record) {
+  _page_selects++;
+  int16_t page = record->value;
+  _sim.writeRegister(PCM51XX_REG_PAGE_SELECT, record->value);
+  if (page == _page) {
+    _redundant_selects++;
+    record->note = "redundant page select";
+    return;
+  }
+  if (page == _previous_page && _visit <= _window) {
+    _bounces++;
+    record->note = "page bounce";
+  }
+  _previous_page = _page;
+  _page = page;
+  _visit = 0;
+}
+
+/*!
+ * @brief Find the counters of a register on the current page
+ * @param reg Register address
+ * @return Counters, created on first use
+ */
+reg_counts_t* Replay::counts(uint8_t reg) {
+  uint16_t key = _page << 8 | reg;
+  for (size_t i = 0; i < _counts.size(); i++) {
+    if (_counts[i].key == key) {
+      return &_counts[i];
+    }
+  }
+  reg_counts_t c = {key, 0, 0, 0, 0};
+  _counts.push_back(c);
+  return &_counts.back();
+}
+
+/*!
+ * @brief Mark every register unknown
+ */
+void Replay::forget(void) {
+  memset(_known, 0, sizeof(_known));
+}
+
+/*!
+ * @brief Print the summary of a replayed trace
+ * @param number Trace number in the log, from 1
+ * @param trace Replayed trace
+ * @param options Command line options
+ */
+void Replay::report(int number, const trace_t* trace,
+                    const options_t* options) {
+  const std::vector<trace_record_t>& records = trace->records;
+  uint32_t start = records.empty() ? 0 : records.front().time;
+  uint32_t span = records.empty() ? 0 : records.back().time - start;
+  printf("trace %d: %u accesses over %u us", number,
+         (unsigned)records.size(), (unsigned)span);
+  if (trace->dropped) {
+    printf(", %u older ones overwritten", (unsigned)trace->dropped);
+  }
+  printf("\n");
+  printf("  reads          %6u  unnecessary %u\n", _reads, _unnecessary_reads);
+  printf("  writes         %6u  redundant %u\n", _writes, _redundant_writes);
+  printf("  page selects   %6u  redundant %u, bounces %u\n", _page_selects,
+         _redundant_selects, _bounces);
+  printf("  failed         %6u\n", _failed);
+  printf("  mismatches     %6u\n", _mismatches);
+  if (_unknown_page) {
+    printf("  unknown page   %6u  (before the first page select)\n",
+           _unknown_page);
+  }
+
+  std::vector<reg_counts_t> wasted;
+  for (size_t i = 0; i < _counts.size(); i++) {
+    if (_counts[i].redundant + _counts[i].unnecessary) {
+      wasted.push_back(_counts[i]);
+    }
+  }
+  std::stable_sort(wasted.begin(), wasted.end(),
+                   [](const reg_counts_t& a, const reg_counts_t& b) {
+                     return a.redundant + a.unnecessary >
+                            b.redundant + b.unnecessary;
+                   });
+  if (!wasted.empty()) {
+    printf("  most wasted (page reg: reads writes redundant unnecessary)\n");
+    for (size_t i = 0; i < wasted.size() && (int)i < options->top; i++) {
+      const reg_counts_t& c = wasted[i];
+      printf("    %3u 0x%02X: %5u %6u %9u %11u\n", c.key >> 8, c.key & 0xFF,
+             c.reads, c.writes, c.redundant, c.unnecessary);
+    }
+  }
+
+  if (options->state) {
+    printf("  register state at the end of the trace\n");
+    for (uint16_t page = 0; page < 256; page++) {
+      for (uint8_t reg = 0; reg < 128; reg++) {
+        if (_known[page][reg]) {
+          printf("    %3u 0x%02X = 0x%02X\n", page, reg,
+                 _sim.peek(page, reg));
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * @brief Print one replayed access
+ * @param record Replayed access
+ * @param start micros() of the first access in the trace
+ */
+static void describe(const trace_record_t* record, uint32_t start) {
+  char page[4] = "?";
+  if (record->page != UNKNOWN_PAGE) {
+    snprintf(page, sizeof(page), "%d", record->page);
+  }
+  printf("%10u  %3s  %s  0x%02X  0x%02X  %s", (unsigned)(record->time - start),
+         page, record->write ? "W" : "R", record->reg, record->value,
+         record->failed ? "FAILED " : "");
+  if (record->note) {
+    printf("%s", record->note);
+    if (!strcmp(record->note, "mismatch, expected")) {
+      printf(" 0x%02X", record->expected);
+    }
+  }
+  printf("\n");
+}
+
+/*!
+ * @brief Decode the records of a trace and fill in their times
+ * @param trace Trace to fill in
+ * @param data Record bytes
+ * @param count Records announced by the header
+ * @param time micros() of the last record
+ */
+static void decode(trace_t* trace, const std::vector<uint8_t>& data,
+                   uint32_t count, uint32_t time) {
+  if (data.size() != count * PCM51XX_TRACE_RECORD) {
+    fail("trace holds %u bytes, header says %u records",
+         (unsigned)data.size(), (unsigned)count);
+  }
+  for (size_t i = 0; i < data.size(); i += PCM51XX_TRACE_RECORD) {
+    uint16_t word = data[i + 2] | data[i + 3] << 8;
+    trace_record_t r = {};
+    r.reg = data[i] & 0x7F;
+    r.write = data[i] & PCM51XX_TRACE_WRITE;
+    r.value = data[i + 1];
+    r.failed = word & PCM51XX_TRACE_FAILED;
+    r.delta = word & PCM51XX_TRACE_MAX_DELTA;
+    r.page = UNKNOWN_PAGE;
+    trace->records.push_back(r);
+  }
+  // Timestamps count back from the last record's micros()
+  for (size_t i = trace->records.size(); i-- > 0;) {
+    trace->records[i].time = time;
+    time -= trace->records[i].delta;
+  }
+}
+
+/*!
+ * @brief Find the hex record data at the end of a log line
+ * @param line Log line
+ * @param data Where to append the decoded bytes
+ * @return True if the line carried record data
+ */
+static bool parseHex(const std::string& line, std::vector<uint8_t>* data) {
+  size_t end = line.size();
+  while (end && isspace((unsigned char)line[end - 1])) {
+    end--;
+  }
+  size_t begin = end;
+  while (begin && isxdigit((unsigned char)line[begin - 1])) {
+    begin--;
+  }
+  if (end - begin < 8) {
+    return false;
+  }
+  if ((end - begin) % 2) {
+    fail("odd number of hex digits in \"%s\"", line.c_str());
+  }
+  for (size_t i = begin; i < end; i += 2) {
+    data->push_back(strtoul(line.substr(i, 2).c_str(), nullptr, 16));
+  }
+  return true;
+}
+
+/*!
+ * @brief Read one line of any length
+ * @param in File to read from
+ * @param line Where to store the line
+ * @return True if a line was read, false at the end of the file
+ */
+static bool readLine(FILE* in, std::string* line) {
+  char buffer[256];
+  line->clear();
+  while (fgets(buffer, sizeof(buffer), in)) {
+    *line += buffer;
+    if (line->back() == '\n') {
+      return true;
+    }
+  }
+  return !line->empty();
+}
+
+/*!
+ * @brief Replay and report every trace in a serial log
+ * @param in Serial log
+ * @param options Command line options
+ * @return Number of traces found
+ */
+static int replayLog(FILE* in, const options_t* options) {
+  static const char header[] = "pcm51xx,trace,";
+  std::string line;
+  bool inside = false;
+  unsigned version, page, time, count, dropped;
+  std::vector<uint8_t> data;
+  int found = 0;
+
+  while (readLine(in, &line)) {
+    size_t at = line.find(header);
+    if (!inside) {
+      if (at != std::string::npos &&
+          sscanf(line.c_str() + at, "pcm51xx,trace,%u,%u,%u,%u,%u", &version,
+                 &page, &time, &count, &dropped) == 5) {
+        if (version != 1) {
+          fail("unknown trace format %u", version);
+        }
+        inside = true;
+        data.clear();
+      }
+      continue;
+    }
+    if (at != std::string::npos &&
+        !strncmp(line.c_str() + at + sizeof(header) - 1, "end", 3)) {
+      trace_t trace;
+      trace.page = page == 0xFF ? UNKNOWN_PAGE : page;
+      trace.dropped = dropped;
+      decode(&trace, data, count, time);
+
+      Replay replay(trace.page, options->window);
+      uint32_t start = trace.records.empty() ? 0 : trace.records[0].time;
+      if (options->records) {
+        printf("    time_us page    reg  value\n");
+      }
+      for (size_t i = 0; i < trace.records.size(); i++) {
+        replay.run(&trace.records[i]);
+        if (options->records) {
+          describe(&trace.records[i], start);
+        }
+      }
+      replay.report(++found, &trace, options);
+      inside = false;
+      continue;
+    }
+    parseHex(line, &data);
+  }
+  if (inside) {
+    fail("trace is missing its end line");
+  }
+  return found;
+}
+
+/*!
+ * @brief Print the usage and exit
+ */
+static void usage(void) {
+  fprintf(stderr,
+          "usage: pcm51xx_trace [-r] [-s] [-t N] [-w N] [log]\n"
+          "  -r  print every access as it is replayed\n"
+          "  -s  print the known register state at the end\n"
+          "  -t  registers to list in the summary (10)\n"
+          "  -w  most accesses on a page for a return to the previous one\n"
+          "      to count as a bounce (2)\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  options_t options = {false, false, 10, 2};
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-r")) {
+      options.records = true;
+    } else if (!strcmp(argv[i], "-s")) {
+      options.state = true;
+    } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      options.top = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+      options.window = atoi(argv[++i]);
+    } else if (argv[i][0] == '-' || path) {
+      usage();
+    } else {
+      path = argv[i];
+    }
+  }
+
+  FILE* in = path ? fopen(path, "r") : stdin;
+  if (!in) {
+    fail("cannot open %s", path);
+  }
+  if (!replayLog(in, &options)) {
+    fail("no trace found, is PCM51XX_TRACE set?");
+  }
+  return 0;
+}
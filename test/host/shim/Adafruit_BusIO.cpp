@@ -0,0 +1,197 @@
+/*!
+ * @file Adafruit_BusIO.cpp
+ *
+ * Host stand-ins for the Adafruit BusIO I2C and SPI devices
+ */
+
+#include "Adafruit_I2CDevice.h"
+#include "Adafruit_SPIDevice.h"
+#include "host_bus.h"
+
+/*! @brief Bytes a Wire transfer can carry, as on AVR */
+#define HOST_I2C_BUFFER 32
+
+/*!
+ * @brief Create an I2C device
+ * @param addr 7-bit device address
+ * @param theWire I2C bus, ignored
+ */
+Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire* theWire) {
+  (void)theWire;
+  _addr = addr;
+}
+
+/*!
+ * @brief Get the device address
+ * @return 7-bit device address
+ */
+uint8_t Adafruit_I2CDevice::address(void) {
+  return _addr;
+}
+
+/*!
+ * @brief Start the device
+ * @param addr_detect Check that a device answers at the address
+ * @return True if a device answers or detection is off
+ */
+bool Adafruit_I2CDevice::begin(bool addr_detect) {
+  return !addr_detect || hostI2CDetect(_addr);
+}
+
+/*!
+ * @brief Read bytes without writing a register address first
+ * @param buffer Buffer for the data
+ * @param len Number of bytes
+ * @param stop Send a STOP after the transfer, ignored
+ * @return True if successful
+ */
+bool Adafruit_I2CDevice::read(uint8_t* buffer, size_t len, bool stop) {
+  (void)stop;
+  if (len > HOST_I2C_BUFFER) {
+    return false;
+  }
+  return hostI2CTransfer(_addr, nullptr, 0, buffer, len);
+}
+
+/*!
+ * @brief Write a prefix and a buffer in one transfer
+ * @param buffer Data to write
+ * @param len Number of data bytes
+ * @param stop Send a STOP after the transfer, ignored
+ * @param prefix_buffer Bytes sent before the data, e.g. a register address
+ * @param prefix_len Number of prefix bytes
+ * @return True if successful
+ */
+bool Adafruit_I2CDevice::write(const uint8_t* buffer, size_t len, bool stop,
+                               const uint8_t* prefix_buffer,
+                               size_t prefix_len) {
+  (void)stop;
+  uint8_t data[HOST_I2C_BUFFER];
+  if (prefix_len + len > sizeof(data)) {
+    return false;
+  }
+  if (prefix_len) {
+    memcpy(data, prefix_buffer, prefix_len);
+  }
+  if (len) {
+    memcpy(data + prefix_len, buffer, len);
+  }
+  return hostI2CTransfer(_addr, data, prefix_len + len, nullptr, 0);
+}
+
+/*!
+ * @brief Write bytes, then read with a repeated START
+ * @param write_buffer Data to write
+ * @param write_len Number of bytes to write
+ * @param read_buffer Buffer for the data read
+ * @param read_len Number of bytes to read
+ * @param stop Send a STOP between write and read, ignored
+ * @return True if successful
+ */
+bool Adafruit_I2CDevice::write_then_read(const uint8_t* write_buffer,
+                                         size_t write_len, uint8_t* read_buffer,
+                                         size_t read_len, bool stop) {
+  (void)stop;
+  if (write_len > HOST_I2C_BUFFER || read_len > HOST_I2C_BUFFER) {
+    return false;
+  }
+  return hostI2CTransfer(_addr, write_buffer, write_len, read_buffer,
+                         read_len);
+}
+
+/*!
+ * @brief Get the largest transfer the bus can carry
+ * @return Bytes per transfer
+ */
+size_t Adafruit_I2CDevice::maxBufferSize(void) {
+  return HOST_I2C_BUFFER;
+}
+
+/*!
+ * @brief Create a hardware SPI device
+ * @param cspin Chip select pin
+ * @param freq Clock frequency, ignored
+ * @param dataOrder Bit order, ignored
+ * @param dataMode SPI mode, ignored
+ * @param theSPI SPI bus, ignored
+ */
+Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, uint32_t freq,
+                                       BusIOBitOrder dataOrder,
+                                       uint8_t dataMode, SPIClass* theSPI) {
+  (void)freq;
+  (void)dataOrder;
+  (void)dataMode;
+  (void)theSPI;
+  _cs = cspin;
+}
+
+/*!
+ * @brief Create a software SPI device
+ * @param cspin Chip select pin
+ * @param sck Clock pin, ignored
+ * @param miso MISO pin, ignored
+ * @param mosi MOSI pin, ignored
+ * @param freq Clock frequency, ignored
+ * @param dataOrder Bit order, ignored
+ * @param dataMode SPI mode, ignored
+ */
+Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, int8_t sck, int8_t miso,
+                                       int8_t mosi, uint32_t freq,
+                                       BusIOBitOrder dataOrder,
+                                       uint8_t dataMode) {
+  (void)sck;
+  (void)miso;
+  (void)mosi;
+  (void)freq;
+  (void)dataOrder;
+  (void)dataMode;
+  _cs = cspin;
+}
+
+/*!
+ * @brief Start the device
+ * @return Always true, SPI has no presence detection
+ */
+bool Adafruit_SPIDevice::begin(void) {
+  return true;
+}
+
+/*!
+ * @brief Write a prefix and a buffer with chip select held
+ * @param buffer Data to write
+ * @param len Number of data bytes
+ * @param prefix_buffer Bytes sent before the data, e.g. a register address
+ * @param prefix_len Number of prefix bytes
+ * @return True if successful
+ */
+bool Adafruit_SPIDevice::write(const uint8_t* buffer, size_t len,
+                               const uint8_t* prefix_buffer,
+                               size_t prefix_len) {
+  uint8_t data[256];
+  if (prefix_len + len > sizeof(data)) {
+    return false;
+  }
+  if (prefix_len) {
+    memcpy(data, prefix_buffer, prefix_len);
+  }
+  if (len) {
+    memcpy(data + prefix_len, buffer, len);
+  }
+  return hostSPITransfer(_cs, data, prefix_len + len, nullptr, 0);
+}
+
+/*!
+ * @brief Write bytes, then read with chip select held
+ * @param write_buffer Data to write
+ * @param write_len Number of bytes to write
+ * @param read_buffer Buffer for the data read
+ * @param read_len Number of bytes to read
+ * @param sendvalue Byte clocked out while reading, ignored
+ * @return True if successful
+ */
+bool Adafruit_SPIDevice::write_then_read(const uint8_t* write_buffer,
+                                         size_t write_len, uint8_t* read_buffer,
+                                         size_t read_len, uint8_t sendvalue) {
+  (void)sendvalue;
+  return hostSPITransfer(_cs, write_buffer, write_len, read_buffer, read_len);
+}
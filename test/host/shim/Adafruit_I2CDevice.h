@@ -0,0 +1,33 @@
+/*!
+ * @file Adafruit_I2CDevice.h
+ *
+ * Host stand-in for the Adafruit BusIO I2C device, talking to the simulated
+ * devices through host_bus.h
+ */
+
+#ifndef _HOST_ADAFRUIT_I2CDEVICE_H
+#define _HOST_ADAFRUIT_I2CDEVICE_H
+
+#include "Wire.h"
+
+/*!
+ * @brief I2C device with the Adafruit BusIO interface
+ */
+class Adafruit_I2CDevice {
+ public:
+  Adafruit_I2CDevice(uint8_t addr, TwoWire* theWire = &Wire);
+  uint8_t address(void);
+  bool begin(bool addr_detect = true);
+  bool read(uint8_t* buffer, size_t len, bool stop = true);
+  bool write(const uint8_t* buffer, size_t len, bool stop = true,
+             const uint8_t* prefix_buffer = nullptr, size_t prefix_len = 0);
+  bool write_then_read(const uint8_t* write_buffer, size_t write_len,
+                       uint8_t* read_buffer, size_t read_len,
+                       bool stop = false);
+  size_t maxBufferSize(void);
+
+ private:
+  uint8_t _addr; ///< 7-bit device address
+};
+
+#endif
@@ -0,0 +1,42 @@
+/*!
+ * @file Adafruit_SPIDevice.h
+ *
+ * Host stand-in for the Adafruit BusIO SPI device, talking to the simulated
+ * devices through host_bus.h
+ */
+
+#ifndef _HOST_ADAFRUIT_SPIDEVICE_H
+#define _HOST_ADAFRUIT_SPIDEVICE_H
+
+#include "SPI.h"
+
+/*! @brief SPI bit order */
+typedef enum {
+  SPI_BITORDER_MSBFIRST = MSBFIRST, ///< Most significant bit first
+  SPI_BITORDER_LSBFIRST = LSBFIRST, ///< Least significant bit first
+} BusIOBitOrder;
+
+/*!
+ * @brief SPI device with the Adafruit BusIO interface
+ */
+class Adafruit_SPIDevice {
+ public:
+  Adafruit_SPIDevice(int8_t cspin, uint32_t freq = 1000000,
+                     BusIOBitOrder dataOrder = SPI_BITORDER_MSBFIRST,
+                     uint8_t dataMode = SPI_MODE0, SPIClass* theSPI = &SPI);
+  Adafruit_SPIDevice(int8_t cspin, int8_t sck, int8_t miso, int8_t mosi,
+                     uint32_t freq = 1000000,
+                     BusIOBitOrder dataOrder = SPI_BITORDER_MSBFIRST,
+                     uint8_t dataMode = SPI_MODE0);
+  bool begin(void);
+  bool write(const uint8_t* buffer, size_t len,
+             const uint8_t* prefix_buffer = nullptr, size_t prefix_len = 0);
+  bool write_then_read(const uint8_t* write_buffer, size_t write_len,
+                       uint8_t* read_buffer, size_t read_len,
+                       uint8_t sendvalue = 0xFF);
+
+ private:
+  int8_t _cs; ///< Chip select pin
+};
+
+#endif
@@ -0,0 +1,297 @@
+/*!
+ * @file Arduino.cpp
+ *
+ * Minimal Arduino core for building the library on a host computer
+ */
+
+#include "Arduino.h"
+
+#include <stdio.h>
+
+#include <atomic>
+
+#include "SPI.h"
+#include "Wire.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+
+static std::atomic<uint32_t> host_clock(0); ///< Simulated time in us
+static void (*host_isrs[HOST_NUM_PINS])(void);
+
+/*!
+ * @brief Get the simulated time, moving it on by 1us
+ * @return Microseconds since start
+ */
+uint32_t micros(void) {
+  return ++host_clock;
+}
+
+/*!
+ * @brief Get the simulated time in milliseconds
+ * @return Milliseconds since start
+ */
+uint32_t millis(void) {
+  return micros() / 1000;
+}
+
+/*!
+ * @brief Move the simulated time on without sleeping
+ * @param ms Milliseconds to wait
+ */
+void delay(uint32_t ms) {
+  host_clock += ms * 1000;
+}
+
+/*!
+ * @brief Move the simulated time on without sleeping
+ * @param us Microseconds to wait
+ */
+void delayMicroseconds(uint32_t us) {
+  host_clock += us;
+}
+
+/*!
+ * @brief Move the simulated time on, for tests waiting on the chip
+ * @param us Microseconds to add
+ */
+void hostAdvanceMicros(uint32_t us) {
+  host_clock += us;
+}
+
+/*!
+ * @brief Give other work a chance to run, nothing to do on the host
+ */
+void yield(void) {}
+
+/*!
+ * @brief Set a pin mode, ignored on the host
+ * @param pin Pin number
+ * @param mode Pin mode
+ */
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+/*!
+ * @brief Drive a pin, ignored on the host
+ * @param pin Pin number
+ * @param value Pin level
+ */
+void digitalWrite(uint8_t pin, uint8_t value) {
+  (void)pin;
+  (void)value;
+}
+
+/*!
+ * @brief Read a pin
+ * @param pin Pin number
+ * @return Always LOW on the host
+ */
+int digitalRead(uint8_t pin) {
+  (void)pin;
+  return LOW;
+}
+
+/*!
+ * @brief Register an interrupt handler, see hostInterrupt()
+ * @param irq Interrupt number
+ * @param isr Handler
+ * @param mode Edge to trigger on, ignored
+ */
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode) {
+  (void)mode;
+  if (irq < HOST_NUM_PINS) {
+    host_isrs[irq] = isr;
+  }
+}
+
+/*!
+ * @brief Remove an interrupt handler
+ * @param irq Interrupt number
+ */
+void detachInterrupt(uint8_t irq) {
+  if (irq < HOST_NUM_PINS) {
+    host_isrs[irq] = nullptr;
+  }
+}
+
+/*!
+ * @brief Disable interrupts, nothing to do on the host
+ */
+void noInterrupts(void) {}
+
+/*!
+ * @brief Enable interrupts, nothing to do on the host
+ */
+void interrupts(void) {}
+
+/*!
+ * @brief Run the handler attached to an interrupt, as a pin edge would
+ * @param irq Interrupt number
+ * @return True if a handler was attached and ran
+ */
+bool hostInterrupt(uint8_t irq) {
+  if (irq >= HOST_NUM_PINS || !host_isrs[irq]) {
+    return false;
+  }
+  host_isrs[irq]();
+  return true;
+}
+
+/*!
+ * @brief Write a buffer one byte at a time
+ * @param buffer Bytes to write
+ * @param size Number of bytes
+ * @return Number of bytes written
+ */
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  for (size_t i = 0; i < size; i++) {
+    n += write(buffer[i]);
+  }
+  return n;
+}
+
+/*!
+ * @brief Print a flash string
+ * @param s String to print
+ * @return Number of bytes written
+ */
+size_t Print::print(const __FlashStringHelper* s) {
+  return print(reinterpret_cast<const char*>(s));
+}
+
+/*!
+ * @brief Print a string
+ * @param s String to print
+ * @return Number of bytes written
+ */
+size_t Print::print(const char* s) {
+  return write(reinterpret_cast<const uint8_t*>(s), strlen(s));
+}
+
+/*!
+ * @brief Print a character
+ * @param c Character to print
+ * @return Number of bytes written
+ */
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+/*!
+ * @brief Print a number
+ * @param value Number to print
+ * @param base Number base
+ * @return Number of bytes written
+ */
+size_t Print::print(unsigned char value, int base) {
+  return printNumber(value, base);
+}
+
+/*!
+ * @brief Print a number
+ * @param value Number to print
+ * @param base Number base
+ * @return Number of bytes written
+ */
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+/*!
+ * @brief Print a number
+ * @param value Number to print
+ * @param base Number base
+ * @return Number of bytes written
+ */
+size_t Print::print(unsigned int value, int base) {
+  return printNumber(value, base);
+}
+
+/*!
+ * @brief Print a number
+ * @param value Number to print
+ * @param base Number base
+ * @return Number of bytes written
+ */
+size_t Print::print(long value, int base) {
+  if (value < 0 && base == DEC) {
+    return print('-') + printNumber(-(unsigned long)value, base);
+  }
+  return printNumber(value, base);
+}
+
+/*!
+ * @brief Print a number
+ * @param value Number to print
+ * @param base Number base
+ * @return Number of bytes written
+ */
+size_t Print::print(unsigned long value, int base) {
+  return printNumber(value, base);
+}
+
+/*!
+ * @brief Print a floating point number
+ * @param value Number to print
+ * @param digits Number of decimals
+ * @return Number of bytes written
+ */
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+/*!
+ * @brief Print a newline
+ * @return Number of bytes written
+ */
+size_t Print::println(void) {
+  return print("\r\n");
+}
+
+/*!
+ * @brief Print an unsigned number in a base
+ * @param value Number to print
+ * @param base Number base, 2 to 16
+ * @return Number of bytes written
+ */
+size_t Print::printNumber(unsigned long value, int base) {
+  char text[8 * sizeof(long) + 1];
+  char* p = &text[sizeof(text) - 1];
+  *p = '\0';
+  if (base < 2 || base > 16) {
+    base = DEC;
+  }
+  do {
+    *--p = "0123456789ABCDEF"[value % base];
+    value /= base;
+  } while (value);
+  return print(p);
+}
+
+/*!
+ * @brief Open the port, nothing to do on the host
+ * @param baud Baud rate
+ */
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+/*!
+ * @brief Write one byte to stdout
+ * @param c Byte to write
+ * @return Number of bytes written
+ */
+size_t HardwareSerial::write(uint8_t c) {
+  // Arduino line endings are \r\n, keep host output plain
+  if (c == '\r') {
+    return 1;
+  }
+  return putchar(c) == EOF ? 0 : 1;
+}
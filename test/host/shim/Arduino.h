@@ -0,0 +1,161 @@
+/*!
+ * @file Arduino.h
+ *
+ * Minimal Arduino core for building the library on a host computer
+ *
+ * Time is simulated: every micros() or millis() call moves the clock on by
+ * 1us and delay() moves it on without sleeping, so host runs are fast and
+ * give the same results every time.
+ */
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef bool boolean; ///< Arduino boolean type
+
+#define HIGH 1           ///< Pin level high
+#define LOW 0            ///< Pin level low
+#define INPUT 0          ///< Pin mode input
+#define OUTPUT 1         ///< Pin mode output
+#define INPUT_PULLUP 2   ///< Pin mode input with pull-up
+#define CHANGE 1         ///< Interrupt on any edge
+#define FALLING 2        ///< Interrupt on falling edge
+#define RISING 3         ///< Interrupt on rising edge
+#define LSBFIRST 0       ///< Least significant bit first
+#define MSBFIRST 1       ///< Most significant bit first
+#define DEC 10           ///< Decimal print base
+#define HEX 16           ///< Hexadecimal print base
+#define LED_BUILTIN 13   ///< On-board LED pin
+#define HOST_NUM_PINS 64 ///< Pins with interrupt support
+/*! @brief Arduino pi constant */
+#define PI 3.1415926535897932384626433832795
+
+#define PROGMEM                                       ///< No flash sections
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr)) ///< Flash byte read
+#define memcpy_P memcpy                               ///< Flash copy
+
+class __FlashStringHelper;
+/*! @brief Flash string literal, a plain string on the host */
+#define F(string) (reinterpret_cast<const __FlashStringHelper*>(string))
+
+/*! @brief Clamp a value to a range */
+#define constrain(amt, low, high) \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+/*!
+ * @brief Smaller of two values, like the Arduino core template
+ * @param a First value
+ * @param b Second value
+ * @return The smaller value
+ */
+template <class T, class L>
+auto min(const T& a, const L& b) -> decltype((b < a) ? b : a) {
+  return (b < a) ? b : a;
+}
+
+/*!
+ * @brief Larger of two values, like the Arduino core template
+ * @param a First value
+ * @param b Second value
+ * @return The larger value
+ */
+template <class T, class L>
+auto max(const T& a, const L& b) -> decltype((b < a) ? b : a) {
+  return (a < b) ? b : a;
+}
+
+uint32_t micros(void);
+uint32_t millis(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+/*! @brief Interrupt number of a pin, the pin itself on the host */
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t irq);
+void noInterrupts(void);
+void interrupts(void);
+
+void hostAdvanceMicros(uint32_t us);
+bool hostInterrupt(uint8_t irq);
+
+/*!
+ * @brief Text output, like the Arduino Print class
+ */
+class Print {
+ public:
+  virtual ~Print(void) {}
+  /*!
+   * @brief Write one byte
+   * @param c Byte to write
+   * @return Number of bytes written
+   */
+  virtual size_t write(uint8_t c) = 0;
+  size_t write(const uint8_t* buffer, size_t size);
+
+  size_t print(const __FlashStringHelper* s);
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println(void);
+  /*!
+   * @brief Print a value followed by a newline
+   * @param value Value to print
+   * @return Number of bytes written
+   */
+  template <class T>
+  size_t println(T value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  /*!
+   * @brief Print a value in a base or precision followed by a newline
+   * @param value Value to print
+   * @param format Base or number of decimals
+   * @return Number of bytes written
+   */
+  template <class T>
+  size_t println(T value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+
+ private:
+  size_t printNumber(unsigned long value, int base);
+};
+
+/*!
+ * @brief Serial port printing to stdout
+ */
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baud);
+  size_t write(uint8_t c) override;
+  using Print::write;
+  /*!
+   * @brief Check if the port is ready
+   * @return Always true
+   */
+  operator bool(void) {
+    return true;
+  }
+};
+
+extern HardwareSerial Serial; ///< Serial port on stdout
+
+#endif
@@ -0,0 +1,21 @@
+/*!
+ * @file SPI.h
+ *
+ * Host stand-in for the Arduino SPI library
+ */
+
+#ifndef _HOST_SPI_H
+#define _HOST_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0 ///< Clock idle low, sample on rising edge
+
+/*!
+ * @brief SPI bus, only used as a handle on the host
+ */
+class SPIClass {};
+
+extern SPIClass SPI; ///< Default SPI bus
+
+#endif
@@ -0,0 +1,19 @@
+/*!
+ * @file Wire.h
+ *
+ * Host stand-in for the Arduino Wire library
+ */
+
+#ifndef _HOST_WIRE_H
+#define _HOST_WIRE_H
+
+#include "Arduino.h"
+
+/*!
+ * @brief I2C bus, only used as a handle on the host
+ */
+class TwoWire {};
+
+extern TwoWire Wire; ///< Default I2C bus
+
+#endif
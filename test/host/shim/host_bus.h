@@ -0,0 +1,20 @@
+/*!
+ * @file host_bus.h
+ *
+ * Bus hooks behind the host Adafruit_I2CDevice and Adafruit_SPIDevice,
+ * implemented by the simulated devices (see Adafruit_PCM51xx_Sim)
+ */
+
+#ifndef _HOST_BUS_H
+#define _HOST_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+bool hostI2CDetect(uint8_t addr);
+bool hostI2CTransfer(uint8_t addr, const uint8_t* write_buffer,
+                     size_t write_len, uint8_t* read_buffer, size_t read_len);
+bool hostSPITransfer(int8_t cs, const uint8_t* write_buffer, size_t write_len,
+                     uint8_t* read_buffer, size_t read_len);
+
+#endif
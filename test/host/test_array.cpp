@@ -0,0 +1,51 @@
+/*!
+ * @file test_array.cpp
+ *
+ * Host tests of Adafruit_PCM51xx_Array with one DAC failing
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include "Adafruit_PCM51xx_Sim.h"
+#include "host_test.h"
+
+/*!
+ * @brief Only the DACs that took a clock plan report it as theirs
+ */
+static void testClockPlan(void) {
+  Adafruit_PCM51xx_Sim left(PCM51XX_DEFAULT_ADDR);
+  Adafruit_PCM51xx_Sim right(PCM51XX_DEFAULT_ADDR + 1);
+  Adafruit_PCM51xx dac_left, dac_right;
+  CHECK(dac_left.begin(PCM51XX_DEFAULT_ADDR));
+  CHECK(dac_right.begin(PCM51XX_DEFAULT_ADDR + 1));
+
+  Adafruit_PCM51xx_Array array;
+  CHECK(array.add(&dac_left));
+  CHECK(array.add(&dac_right));
+  CHECK_EQ(array.count(), 2);
+
+  pcm51xx_clock_plan_t plan, read_back;
+  CHECK(Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_BCK,
+                                     0, 48000, PCM51XX_I2S_SIZE_32BIT,
+                                     &plan));
+  CHECK(array.applyClockPlan(&plan));
+  CHECK_EQ(array.getFailed(), 0);
+  CHECK(dac_right.getClockPlan(&read_back));
+  CHECK_EQ(read_back.sample_rate, 48000);
+
+  pcm51xx_clock_plan_t other;
+  CHECK(Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_BCK,
+                                     0, 44100, PCM51XX_I2S_SIZE_32BIT,
+                                     &other));
+  right.failTransfers(100);
+  CHECK(!array.applyClockPlan(&other));
+  CHECK_EQ(array.getFailed(), 0x02);
+  CHECK(dac_left.getClockPlan(&read_back));
+  CHECK_EQ(read_back.sample_rate, 44100);
+  CHECK(!dac_right.getClockPlan(&read_back));
+}
+
+int main(void) {
+  testClockPlan();
+  return TEST_RESULT();
+}
@@ -0,0 +1,201 @@
+/*!
+ * @file test_async.cpp
+ *
+ * Host tests of Adafruit_PCM51xx_Async over a transport that completes
+ * transfers on a later poll()
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include "Adafruit_PCM51xx_SimTransport.h"
+#include "host_test.h"
+
+/*! @brief Completion seen by a callback */
+typedef struct {
+  int id;        ///< Operation that completed
+  bool ok;       ///< Result passed to the callback
+  uint8_t value; ///< Value passed to the callback
+  bool busy;     ///< Transport still had a transfer in flight
+} completion_t;
+
+static completion_t completions[16];      ///< Completions in callback order
+static int completed = 0;                 ///< Entries used in completions
+static Adafruit_PCM51xx_SimTransport* tp; ///< Transport under test
+static Adafruit_PCM51xx_Async* queue;     ///< Queue under test
+
+/*!
+ * @brief Callback recording its operation id
+ * @param ok True if the operation succeeded
+ * @param value Register value written or read
+ * @param arg Operation id, cast to a pointer
+ */
+static void record(bool ok, uint8_t value, void* arg) {
+  completion_t c = {(int)(intptr_t)arg, ok, value, tp->busy()};
+  completions[completed++] = c;
+}
+
+/*!
+ * @brief Callback queueing a follow-up write from inside a completion
+ * @param ok True if the operation succeeded
+ * @param value Register value written or read
+ * @param arg Operation id, cast to a pointer
+ */
+static void chain(bool ok, uint8_t value, void* arg) {
+  record(ok, value, arg);
+  queue->write(0, PCM51XX_REG_DIGITAL_VOLUME_R, 0x40, record, (void*)99);
+}
+
+/*!
+ * @brief A write to another page goes out as a page select, then the write
+ */
+static void testPageSelect(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+
+  Adafruit_PCM51xx_SimTransport transport(&sim, 2);
+  Adafruit_PCM51xx_Async async(&pcm, &transport);
+  tp = &transport;
+  completed = 0;
+  sim.enableLog(true);
+
+  CHECK(async.write(1, PCM51XX_REG_PAGE1_VCOM_POWER, 0x00, record,
+                    (void*)1));
+  CHECK_EQ(transport.getStarted(), 0);
+
+  // Page select in flight: nothing reaches the chip until it ends
+  CHECK(async.poll());
+  CHECK_EQ(transport.getStarted(), 1);
+  CHECK(async.poll());
+  CHECK(async.poll());
+  CHECK_EQ(sim.getLog().size(), 0);
+  CHECK(async.poll());
+  CHECK_EQ(sim.getPage(), 1);
+  CHECK_EQ(completed, 0);
+
+  // Then the write itself
+  CHECK_EQ(transport.getStarted(), 2);
+  CHECK(async.poll());
+  CHECK(async.poll());
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x01);
+  CHECK(!async.poll());
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x00);
+  CHECK_EQ(completed, 1);
+  CHECK(completions[0].ok);
+
+  std::vector<pcm51xx_sim_access_t> log = sim.getLog();
+  CHECK_EQ(log.size(), 2);
+  CHECK_EQ(log[0].reg, PCM51XX_REG_PAGE_SELECT);
+  CHECK_EQ(log[0].value, 1);
+  CHECK_EQ(log[1].page, 1);
+  CHECK_EQ(log[1].reg, PCM51XX_REG_PAGE1_VCOM_POWER);
+
+  // The driver knows the chip moved to page 1 and goes back for page 0
+  CHECK(pcm.isVCOMPowered());
+  CHECK(pcm.setVolumeDB(-6.0, -6.0));
+  CHECK_EQ(sim.getPage(), 0);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x3C);
+
+  // A failed page select fails its operation and leaves the page unknown
+  sim.failTransfers(1);
+  CHECK(async.write(1, PCM51XX_REG_PAGE1_VCOM_POWER, 0x01, record,
+                    (void*)2));
+  CHECK(async.flush());
+  CHECK_EQ(completed, 2);
+  CHECK(!completions[1].ok);
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x00);
+  CHECK(pcm.setVolumeDB(-12.0, -12.0));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x48);
+}
+
+/*!
+ * @brief Callbacks run in queue order, each after its transfer has ended
+ */
+static void testCallbackOrder(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  pcm.enableCache(true);
+
+  Adafruit_PCM51xx_SimTransport transport(&sim, 1);
+  Adafruit_PCM51xx_Async async(&pcm, &transport);
+  tp = &transport;
+  queue = &async;
+  completed = 0;
+
+  uint8_t value = 0;
+  sim.poke(1, PCM51XX_REG_PAGE1_VCOM_POWER, 0x00);
+  CHECK(async.write(0, PCM51XX_REG_DIGITAL_VOLUME_L, 0x50, record,
+                    (void*)0));
+  CHECK(async.read(1, PCM51XX_REG_PAGE1_VCOM_POWER, &value, record,
+                   (void*)1));
+  CHECK(async.write(0, PCM51XX_REG_MUTE, 0x00, chain, (void*)2));
+  CHECK(async.read(0, PCM51XX_REG_DIGITAL_VOLUME_L, nullptr, record,
+                   (void*)3));
+  CHECK_EQ(async.pending(), 4);
+  CHECK_EQ(completed, 0);
+
+  CHECK(async.flush());
+  CHECK_EQ(async.pending(), 0);
+  CHECK_EQ(completed, 5);
+  for (int i = 0; i < 4; i++) {
+    CHECK_EQ(completions[i].id, i);
+    CHECK(completions[i].ok);
+  }
+  CHECK_EQ(completions[4].id, 99);
+
+  // Completions only come once the transport has finished the transfer
+  for (int i = 0; i < completed; i++) {
+    CHECK(!completions[i].busy);
+  }
+  CHECK_EQ(value, 0x00);
+  CHECK_EQ(completions[1].value, 0x00);
+  CHECK_EQ(completions[3].value, 0x50);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x50);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_R), 0x40);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_MUTE), 0x00);
+
+  // Operation 3 read a cached register and needed no transfer: writes to
+  // volume, page 1, the read, page 0, mute and the chained write
+  pcm51xx_async_stats_t stats = async.getStats();
+  CHECK_EQ(stats.transfers, 6);
+  CHECK_EQ(transport.getStarted(), 6);
+  CHECK_EQ(stats.completed, 5);
+  CHECK_EQ(stats.failed, 0);
+}
+
+/*!
+ * @brief A queued register reset drops the cache and the clock plan
+ */
+static void testQueuedReset(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  pcm.enableCache(true);
+
+  pcm51xx_clock_plan_t plan;
+  CHECK(Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_BCK,
+                                     0, 48000, PCM51XX_I2S_SIZE_32BIT,
+                                     &plan));
+  CHECK(pcm.applyClockPlan(&plan));
+  CHECK(pcm.setVolumeHalfDB(-40, -40));
+
+  Adafruit_PCM51xx_SimTransport transport(&sim, 1);
+  Adafruit_PCM51xx_Async async(&pcm, &transport);
+  CHECK(async.write(0, PCM51XX_REG_RESET, 0x01));
+  CHECK(async.flush());
+  hostAdvanceMicros(PCM51XX_SIM_RESET_US);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x30);
+  CHECK(!pcm.getClockPlan(&plan));
+
+  CHECK(pcm.setVolumeHalfDB(-40, -40));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x58);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_R), 0x58);
+}
+
+int main(void) {
+  testPageSelect();
+  testCallbackOrder();
+  testQueuedReset();
+  return TEST_RESULT();
+}
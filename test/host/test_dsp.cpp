@@ -0,0 +1,82 @@
+/*!
+ * @file test_dsp.cpp
+ *
+ * Host tests of coefficient RAM updates
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include "Adafruit_PCM51xx_Sim.h"
+#include "host_test.h"
+
+/*! @brief Two coefficients' worth of data */
+static const uint8_t coefficients[8] = {0x00, 0x80, 0x00, 0x00,
+                                        0x12, 0x34, 0x56, 0x78};
+
+/*!
+ * @brief An adaptive update lands in both buffers and is reported once
+ */
+static void testAdaptiveUpdate(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+
+  // Reference CRC and size of a single copy
+  CHECK(pcm.writeDSPMemory(PCM51XX_PAGE_CRAM_A, PCM51XX_DSP_FIRST_REG,
+                           coefficients, sizeof(coefficients)));
+  pcm51xx_dsp_load_t single = pcm.getDSPLoadInfo();
+  CHECK_EQ(single.bytes, sizeof(coefficients));
+
+  CHECK(pcm.setAdaptiveMode(true));
+  uint32_t start = micros();
+  CHECK(pcm.updateCoefficients(4, coefficients, sizeof(coefficients)));
+  uint32_t elapsed = micros() - start;
+
+  pcm51xx_dsp_load_t load = pcm.getDSPLoadInfo();
+  CHECK_EQ(load.bytes, 2 * sizeof(coefficients));
+  CHECK_EQ(load.crc, single.crc);
+  CHECK(!load.verified);
+  CHECK(load.time >= PCM51XX_SIM_SWAP_US);
+  CHECK(load.time <= elapsed);
+
+  uint8_t reg = PCM51XX_DSP_FIRST_REG + 4;
+  for (uint8_t i = 0; i < sizeof(coefficients); i++) {
+    CHECK_EQ(sim.peek(PCM51XX_PAGE_CRAM_A, reg + i), coefficients[i]);
+    CHECK_EQ(sim.peek(PCM51XX_PAGE_CRAM_B, reg + i), coefficients[i]);
+  }
+}
+
+/*!
+ * @brief A script that resets the registers leaves no stale state behind
+ */
+static void testScriptReset(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  pcm.enableCache(true);
+
+  pcm51xx_clock_plan_t plan;
+  CHECK(Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_BCK,
+                                     0, 48000, PCM51XX_I2S_SIZE_32BIT,
+                                     &plan));
+  CHECK(pcm.applyClockPlan(&plan));
+  CHECK(pcm.setVolumeHalfDB(-40, -40));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x58);
+
+  // How a PPC3 export starts: page 0, reset registers
+  static const uint8_t script[] = {0x00, 0x00, 0x01, 0x11};
+  CHECK(pcm.loadDSPScript(script, sizeof(script)));
+  hostAdvanceMicros(PCM51XX_SIM_RESET_US);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x30);
+  CHECK(!pcm.getClockPlan(&plan));
+
+  CHECK(pcm.setVolumeHalfDB(-40, -40));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x58);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_R), 0x58);
+}
+
+int main(void) {
+  testAdaptiveUpdate();
+  testScriptReset();
+  return TEST_RESULT();
+}
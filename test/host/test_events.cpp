@@ -0,0 +1,93 @@
+/*!
+ * @file test_events.cpp
+ *
+ * Host tests of event pins and their dispatch
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include "Adafruit_PCM51xx_Sim.h"
+#include "host_test.h"
+
+static int calls = 0;       ///< Callbacks seen
+static bool active = false; ///< State passed to the last callback
+
+/*!
+ * @brief Event callback counting its calls
+ * @param event Event that changed
+ * @param state True if it started, false if it cleared
+ */
+static void onPLLUnlock(pcm51xx_event_t event, bool state) {
+  CHECK_EQ(event, PCM51XX_EVENT_PLL_UNLOCK);
+  calls++;
+  active = state;
+}
+
+/*!
+ * @brief Attaching a pin twice keeps one slot, other instances can't take it
+ */
+static void testAttach(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm, other;
+  CHECK(pcm.begin());
+
+  CHECK(pcm.attachEventPin(2));
+  CHECK(pcm.attachEventPin(2));
+  CHECK(!other.attachEventPin(2));
+  CHECK(pcm.attachEventPin(3));
+  CHECK(pcm.attachEventPin(4));
+  CHECK(other.attachEventPin(5));
+  CHECK(!pcm.attachEventPin(6));
+
+  // Freed slots can be taken by anyone
+  pcm.detachEventPins();
+  CHECK(other.attachEventPin(2));
+  CHECK(other.attachEventPin(2));
+  CHECK(pcm.attachEventPin(3));
+  CHECK(pcm.attachEventPin(4));
+  CHECK(!pcm.attachEventPin(6));
+  pcm.detachEventPins();
+  other.detachEventPins();
+}
+
+/*!
+ * @brief A pin change leads to one status read and one callback
+ */
+static void testDispatch(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  CHECK(pcm.routeEvent(PCM51XX_EVENT_PLL_UNLOCK, 4));
+  CHECK(pcm.onEvent(PCM51XX_EVENT_PLL_UNLOCK, onPLLUnlock));
+  CHECK(pcm.attachEventPin(2));
+  CHECK(pcm.attachEventPin(2));
+
+  // The PLL flag is high while locked
+  sim.poke(0, PCM51XX_REG_GPIO_INPUT, 0x08);
+  CHECK_EQ(pcm.handleEvents(), 0);
+
+  sim.resetStats();
+  CHECK_EQ(pcm.handleEvents(), 0);
+  CHECK_EQ(sim.getStats().transactions, 0);
+
+  sim.poke(0, PCM51XX_REG_GPIO_INPUT, 0x00);
+  CHECK(hostInterrupt(2));
+  CHECK_EQ(pcm.handleEvents(), 1 << PCM51XX_EVENT_PLL_UNLOCK);
+  CHECK_EQ(calls, 1);
+  CHECK(active);
+  CHECK_EQ(pcm.getActiveEvents(), 1 << PCM51XX_EVENT_PLL_UNLOCK);
+
+  sim.poke(0, PCM51XX_REG_GPIO_INPUT, 0x08);
+  CHECK(hostInterrupt(2));
+  CHECK_EQ(pcm.handleEvents(), 1 << PCM51XX_EVENT_PLL_UNLOCK);
+  CHECK_EQ(calls, 2);
+  CHECK(!active);
+  CHECK_EQ(pcm.handleEvents(), 0);
+  pcm.detachEventPins();
+}
+
+int main(void) {
+  testAttach();
+  testDispatch();
+  return TEST_RESULT();
+}
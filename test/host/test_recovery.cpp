@@ -0,0 +1,88 @@
+/*!
+ * @file test_recovery.cpp
+ *
+ * Host tests of reset detection, with the shadow cache on and off
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include "Adafruit_PCM51xx_Sim.h"
+#include "host_test.h"
+
+/*!
+ * @brief A chip that lost power is detected and reconfigured
+ * @param cached True to run with the shadow cache enabled
+ */
+static void testDetectsReset(bool cached) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  pcm.enableCache(cached);
+
+  CHECK(pcm.checkReset());
+  CHECK_EQ(pcm.getErrorStats().resets, 0);
+
+  sim.powerCycle();
+  CHECK(pcm.checkReset());
+  CHECK_EQ(pcm.getErrorStats().resets, 1);
+  CHECK_EQ(pcm.getLastError(), PCM51XX_ERROR_RESET);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_ERROR_DETECT), 0x7D);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_MUTE), 0x11);
+}
+
+/*!
+ * @brief Clearing the error detection register on purpose is not a reset
+ * @param cached True to run with the shadow cache enabled
+ */
+static void testClearedIsNotReset(bool cached) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  pcm.enableCache(cached);
+
+  CHECK(pcm.ignoreFSDetect(false));
+  CHECK(pcm.ignoreBCKDetect(false));
+  CHECK(pcm.ignoreSCKDetect(false));
+  CHECK(pcm.ignoreClockHalt(false));
+  CHECK(pcm.ignoreClockMissing(false));
+  CHECK(pcm.ignorePLLUnlock(false));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_ERROR_DETECT), 0x00);
+  CHECK(pcm.mute(false));
+
+  sim.resetStats();
+  CHECK(pcm.checkReset());
+  CHECK_EQ(pcm.getErrorStats().resets, 0);
+  CHECK_EQ(sim.getStats().transactions, 1);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_ERROR_DETECT), 0x00);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_MUTE), 0x00);
+
+  // Once set again the check is back on
+  CHECK(pcm.ignoreFSDetect(true));
+  sim.powerCycle();
+  CHECK(pcm.checkReset());
+  CHECK_EQ(pcm.getErrorStats().resets, 1);
+}
+
+/*!
+ * @brief A failed write leaves the register unknown, so no reset is claimed
+ */
+static void testUnknownAfterFailedWrite(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+
+  sim.loseAcks(1);
+  CHECK(!pcm.ignoreFSDetect(false));
+  sim.poke(0, PCM51XX_REG_ERROR_DETECT, 0x00);
+  CHECK(pcm.checkReset());
+  CHECK_EQ(pcm.getErrorStats().resets, 0);
+}
+
+int main(void) {
+  testDetectsReset(false);
+  testDetectsReset(true);
+  testClearedIsNotReset(false);
+  testClearedIsNotReset(true);
+  testUnknownAfterFailedWrite();
+  return TEST_RESULT();
+}
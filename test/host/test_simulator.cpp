@@ -0,0 +1,230 @@
+/*!
+ * @file test_simulator.cpp
+ *
+ * Host tests of the PCM51xx simulator and of the driver running against it
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include "Adafruit_PCM51xx_Sim.h"
+#include "host_test.h"
+
+/*!
+ * @brief Page select, read-only bits and the self-clearing reset bits
+ */
+static void testRegisters(void) {
+  Adafruit_PCM51xx_Sim sim;
+
+  sim.writeRegister(PCM51XX_REG_PAGE_SELECT, 1);
+  sim.writeRegister(PCM51XX_REG_PAGE1_VCOM_POWER, 0x00);
+  CHECK_EQ(sim.getPage(), 1);
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x00);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_STANDBY), 0x00);
+
+  sim.writeRegister(PCM51XX_REG_PAGE_SELECT, 0);
+  sim.writeRegister(PCM51XX_REG_POWER_STATE, 0x00);
+  sim.writeRegister(PCM51XX_REG_GPIO_INPUT, 0x3F);
+  CHECK_EQ(sim.getStats().ignored, 2);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_GPIO_INPUT), 0x00);
+  sim.poke(0, PCM51XX_REG_GPIO_INPUT, 0x10);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_GPIO_INPUT), 0x10);
+
+  sim.writeRegister(PCM51XX_REG_DIGITAL_VOLUME_L, 0x80);
+  sim.writeRegister(PCM51XX_REG_RESET, 0x01);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_RESET), 0x01);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_DIGITAL_VOLUME_L), 0x30);
+  hostAdvanceMicros(PCM51XX_SIM_RESET_US);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_RESET), 0x00);
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x01);
+}
+
+/*!
+ * @brief PLL lock and power state follow the control registers over time
+ */
+static void testClocksAndPower(void) {
+  Adafruit_PCM51xx_Sim sim;
+
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_PLL) & 0x10, 0x10);
+  sim.writeRegister(PCM51XX_REG_PLL, 0x11);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_PLL), 0x11);
+  hostAdvanceMicros(PCM51XX_SIM_PLL_LOCK_US);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_PLL), 0x01);
+  sim.setPLLLockable(false);
+  CHECK_EQ(sim.readRegister(PCM51XX_REG_PLL), 0x11);
+
+  hostAdvanceMicros(PCM51XX_SIM_POWER_UP_US);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_POWER_STATE), 0x85);
+  sim.writeRegister(PCM51XX_REG_STANDBY, 0x10);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_POWER_STATE), 0x88);
+  sim.writeRegister(PCM51XX_REG_STANDBY, 0x01);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_POWER_STATE), 0x80);
+  sim.writeRegister(PCM51XX_REG_STANDBY, 0x00);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_POWER_STATE), 0x84);
+  hostAdvanceMicros(PCM51XX_SIM_POWER_UP_US);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_POWER_STATE), 0x85);
+}
+
+/*!
+ * @brief The driver finds the chip, configures it and counts its traffic
+ */
+static void testDriverI2C(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+
+  CHECK(!pcm.begin(PCM51XX_DEFAULT_ADDR + 1));
+  CHECK(pcm.begin());
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_ERROR_DETECT), 0x7D);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_MUTE), 0x11);
+
+  hostAdvanceMicros(PCM51XX_SIM_PLL_LOCK_US);
+  CHECK(pcm.isPLLLocked());
+  hostAdvanceMicros(PCM51XX_SIM_POWER_UP_US);
+  CHECK_EQ(pcm.getPowerState(), PCM51XX_POWER_RUN_PLAYING);
+
+  pcm.resetBusStats();
+  sim.resetStats();
+  CHECK(pcm.setVolumeDB(-20.0, -10.0));
+  CHECK(pcm.setVCOMPower(true));
+  CHECK(pcm.mute(false));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x58);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_R), 0x44);
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x00);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_MUTE), 0x00);
+
+  pcm51xx_bus_stats_t stats = pcm.getBusStats();
+  pcm51xx_sim_stats_t seen = sim.getStats();
+  CHECK(stats.transactions > 0);
+  CHECK_EQ(stats.transactions, seen.transactions);
+  CHECK_EQ(stats.reads, seen.reads);
+  CHECK_EQ(stats.bytes_written, seen.bytes_written);
+  CHECK_EQ(stats.bytes_read, seen.bytes_read);
+  CHECK_EQ(seen.ignored, 0);
+
+  CHECK(pcm.resetRegisters());
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x30);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_RESET), 0x00);
+}
+
+/*!
+ * @brief The same driver calls work over SPI
+ */
+static void testDriverSPI(void) {
+  Adafruit_PCM51xx_Sim sim(PCM51XX_DEFAULT_ADDR, 10);
+  Adafruit_PCM51xx pcm;
+
+  CHECK(pcm.begin(10, &SPI));
+  CHECK(pcm.setVolumeDB(-6.0, -6.0));
+  CHECK(pcm.setVCOMPower(true));
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x3C);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_R), 0x3C);
+  CHECK_EQ(sim.peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x00);
+
+  float left, right;
+  pcm.getVolumeDB(&left, &right);
+  CHECK_EQ(left * 2, -12);
+  CHECK_EQ(right * 2, -12);
+}
+
+/*!
+ * @brief The simulator and the driver agree on which registers are volatile
+ *
+ * Reading a register twice through the async queue with the cache on costs
+ * a second transfer only if the driver treats the register as volatile.
+ */
+static void testVolatileAgreement(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+  pcm.enableCache(true);
+  Adafruit_PCM51xx_Async async(&pcm);
+
+  for (uint8_t page = 0; page < 2; page++) {
+    uint8_t last = page ? PCM51XX_CACHE_PAGE1_REGS : 0x80;
+    for (uint8_t reg = 1; reg < last; reg++) {
+      CHECK(async.read(page, reg, nullptr));
+      CHECK(async.flush());
+      uint32_t transfers = async.getStats().transfers;
+      CHECK(async.read(page, reg, nullptr));
+      CHECK(async.flush());
+      bool reread = async.getStats().transfers != transfers;
+      if (reread != Adafruit_PCM51xx_Sim::isVolatile(page, reg)) {
+        fprintf(stderr, "page %u register 0x%02X: driver %s\n", page, reg,
+                reread ? "volatile" : "cached");
+        CHECK(false);
+      }
+    }
+  }
+}
+
+/*!
+ * @brief Switching to a profile at another sample rate goes through standby
+ */
+static void testProfileClocks(void) {
+  Adafruit_PCM51xx_Sim sim;
+  Adafruit_PCM51xx pcm;
+  CHECK(pcm.begin());
+
+  pcm51xx_clock_plan_t plan;
+  pcm51xx_profile_t at48k, at44k;
+  CHECK(Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_SCK,
+                                     12000000, 48000, PCM51XX_I2S_SIZE_32BIT,
+                                     &plan));
+  CHECK(pcm.applyClockPlan(&plan));
+  CHECK(pcm.captureProfile(&at48k));
+  CHECK(Adafruit_PCM51xx::planClocks(PCM51XX_DAC_CLK_PLL, PCM51XX_PLL_REF_SCK,
+                                     12000000, 44100, PCM51XX_I2S_SIZE_32BIT,
+                                     &plan));
+  CHECK(pcm.applyClockPlan(&plan));
+  CHECK(pcm.captureProfile(&at44k));
+
+  sim.enableLog(true);
+  CHECK(pcm.applyProfile(&at48k));
+  CHECK(!pcm.getClockPlan(&plan));
+
+  // Every clock register write lands between entering and leaving standby
+  std::vector<pcm51xx_sim_access_t> log = sim.getLog();
+  int entered = -1, left = -1, first = -1, last = -1;
+  for (size_t i = 0; i < log.size(); i++) {
+    if (!log[i].write || log[i].page != 0) {
+      continue;
+    }
+    if (log[i].reg == PCM51XX_REG_STANDBY) {
+      if (log[i].value & 0x10) {
+        entered = entered < 0 ? (int)i : entered;
+      } else {
+        left = (int)i;
+      }
+    } else if (log[i].reg >= PCM51XX_REG_PLL_REF &&
+               log[i].reg <= PCM51XX_REG_IDAC_LSB) {
+      first = first < 0 ? (int)i : first;
+      last = (int)i;
+    }
+  }
+  CHECK(first >= 0);
+  CHECK(entered >= 0 && entered < first);
+  CHECK(left > last);
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_STANDBY) & 0x10, 0x00);
+
+  // Without a clock change the chip is left running
+  sim.clearLog();
+  CHECK(pcm.setVolumeDB(-20.0, -20.0));
+  CHECK(pcm.captureProfile(&at44k));
+  CHECK(pcm.setVolumeDB(-10.0, -10.0));
+  sim.clearLog();
+  CHECK(pcm.applyProfile(&at44k));
+  log = sim.getLog();
+  for (size_t i = 0; i < log.size(); i++) {
+    CHECK(!log[i].write || log[i].reg != PCM51XX_REG_STANDBY);
+  }
+  CHECK_EQ(sim.peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x58);
+}
+
+int main(void) {
+  testRegisters();
+  testClocksAndPower();
+  testDriverI2C();
+  testDriverSPI();
+  testVolatileAgreement();
+  testProfileClocks();
+  return TEST_RESULT();
+}
@@ -0,0 +1,165 @@
+/*!
+ * @file test_threads.cpp
+ *
+ * Host stress tests of the lock hooks, where several threads share one DAC
+ * and every page 0 write must land on page 0, and of the command queue
+ */
+
+#include <Adafruit_PCM51xx.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "Adafruit_PCM51xx_Sim.h"
+#include "host_test.h"
+
+/*! @brief Calls each thread makes */
+#define ITERATIONS 20000
+
+static Adafruit_PCM51xx pcm;     ///< DAC shared by the threads
+static std::recursive_mutex bus; ///< Lock installed with setLock()
+static std::atomic<bool> go;     ///< Releases the threads together
+static std::atomic<bool> done;   ///< Producer has posted everything
+static uint32_t accepted;        ///< Writes the producer got posted
+static uint8_t last;             ///< Last volume the producer posted
+/*! @brief Queue between the producer and the draining thread */
+static Adafruit_PCM51xx_CommandQueue commands;
+
+/*!
+ * @brief Lock hook
+ * @param arg Mutex to take
+ */
+static void lock(void* arg) {
+  ((std::recursive_mutex*)arg)->lock();
+}
+
+/*!
+ * @brief Unlock hook
+ * @param arg Mutex to release
+ */
+static void unlock(void* arg) {
+  ((std::recursive_mutex*)arg)->unlock();
+}
+
+/*! @brief Page 1 traffic: VCOM output select and powerdown */
+static void vcomTask(void) {
+  while (!go) {
+  }
+  for (int i = 0; i < ITERATIONS; i++) {
+    pcm.enableVCOM(i & 1);
+    pcm.setVCOMPower(i & 2);
+  }
+}
+
+/*! @brief Page 0 traffic: both volume registers in one burst */
+static void volumeTask(void) {
+  while (!go) {
+  }
+  for (int i = 0; i < ITERATIONS; i++) {
+    pcm.setVolumeDB(-(i % 40), -(i % 20));
+  }
+}
+
+/*! @brief Page 0 traffic: a read-modify-write of the mute register */
+static void muteTask(void) {
+  while (!go) {
+  }
+  for (int i = 0; i < ITERATIONS; i++) {
+    pcm.mute(i & 1);
+  }
+}
+
+/*! @brief Command queue producer: posts volumes without waiting */
+static void producerTask(void) {
+  for (int i = 0; i < ITERATIONS; i++) {
+    uint8_t volume = 0x30 + i % 0x80;
+    if (commands.post(0, PCM51XX_REG_DIGITAL_VOLUME_L, 0xFF, volume)) {
+      accepted++;
+      last = volume;
+    }
+    // Posting never blocks, so give the drain a chance on a single core
+    std::this_thread::yield();
+  }
+  done = true;
+}
+
+/*!
+ * @brief Three threads share the DAC under the lock hooks
+ * @param sim Simulated chip the DAC talks to
+ */
+static void testLock(Adafruit_PCM51xx_Sim* sim) {
+  pcm.setLock(lock, unlock, &bus);
+  sim->resetStats();
+  sim->enableLog(true);
+
+  std::thread vcom(vcomTask);
+  std::thread volume(volumeTask);
+  std::thread mute(muteTask);
+  go = true;
+  vcom.join();
+  volume.join();
+  mute.join();
+
+  // Count writes by the page each register belongs on, and those that
+  // landed on the wrong one
+  std::vector<pcm51xx_sim_access_t> log = sim->getLog();
+  uint32_t page0 = 0, page1 = 0, misplaced = 0;
+  for (size_t i = 0; i < log.size(); i++) {
+    const pcm51xx_sim_access_t& a = log[i];
+    if (!a.write || a.reg == PCM51XX_REG_PAGE_SELECT) {
+      continue;
+    }
+    switch (a.reg) {
+      case PCM51XX_REG_MUTE:
+      case PCM51XX_REG_DIGITAL_VOLUME_L:
+      case PCM51XX_REG_DIGITAL_VOLUME_R:
+        page0++;
+        misplaced += a.page != 0;
+        break;
+      case PCM51XX_REG_PAGE1_OUTPUT_AMP_TYPE:
+      case PCM51XX_REG_PAGE1_VCOM_POWER:
+        page1++;
+        misplaced += a.page != 1;
+        break;
+      default:
+        misplaced++;
+        break;
+    }
+  }
+  CHECK_EQ(misplaced, 0);
+  CHECK_EQ(page0, 3 * ITERATIONS);
+  CHECK_EQ(page1, 2 * ITERATIONS);
+  CHECK_EQ(sim->getStats().ignored, 0);
+
+  // Last values of each thread
+  CHECK_EQ(sim->peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), 0x30 + 2 * 39);
+  CHECK_EQ(sim->peek(0, PCM51XX_REG_DIGITAL_VOLUME_R), 0x30 + 2 * 19);
+  CHECK_EQ(sim->peek(0, PCM51XX_REG_MUTE), 0x11);
+  CHECK_EQ(sim->peek(1, PCM51XX_REG_PAGE1_VCOM_POWER), 0x00);
+}
+
+/*!
+ * @brief One thread posts to a command queue while another drains it
+ * @param sim Simulated chip the DAC talks to
+ */
+static void testCommandQueue(Adafruit_PCM51xx_Sim* sim) {
+  std::thread producer(producerTask);
+  while (!done || commands.pending()) {
+    CHECK(commands.drain(&pcm));
+  }
+  producer.join();
+
+  CHECK(accepted > 0);
+  CHECK_EQ(accepted + commands.getDropped(), ITERATIONS);
+  CHECK_EQ(commands.pending(), 0);
+  CHECK_EQ(sim->peek(0, PCM51XX_REG_DIGITAL_VOLUME_L), last);
+}
+
+int main(void) {
+  Adafruit_PCM51xx_Sim sim;
+  CHECK(pcm.begin());
+  testLock(&sim);
+  testCommandQueue(&sim);
+  return TEST_RESULT();
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Print the flash and RAM used by examples/footprint in every build
+# configuration. Needs arduino-cli with the board core and Adafruit BusIO
+# installed.
+#
+# Usage: tools/footprint.sh [fqbn]    (default: arduino:avr:uno)
+
+FQBN=${1:-arduino:avr:uno}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+printf '%-40s %8s %8s\n' "configuration" "flash" "ram"
+for FLAGS in "" \
+             "-DPCM51XX_NO_CACHE" \
+             "-DPCM51XX_I2C_ONLY" \
+             "-DPCM51XX_I2C_ONLY -DPCM51XX_NO_CACHE" \
+             "-DPCM51XX_SPI_ONLY" \
+             "-DPCM51XX_SPI_ONLY -DPCM51XX_NO_CACHE" \
+             "-DPCM51XX_INSTRUMENT" \
+             "-DPCM51XX_TRACE"; do
+  OUT=$(arduino-cli compile -b "$FQBN" --library "$ROOT" --clean \
+        --build-property "compiler.cpp.extra_flags=$FLAGS" \
+        "$ROOT/examples/footprint" 2>&1)
+  if [ $? -ne 0 ]; then
+    echo "$OUT" >&2
+    exit 1
+  fi
+  FLASH=$(echo "$OUT" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  RAM=$(echo "$OUT" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+  printf '%-40s %8s %8s\n' "${FLAGS:-default}" "$FLASH" "$RAM"
+done